@@ -0,0 +1,44 @@
+# Shared by the benchmarks, which source it after setting LISP to the interpreter to run.
+# RUNS is how many runs each time is the best of, and WORK a directory for generated inputs
+# that is removed on exit.
+
+RUNS=${RUNS:-5}
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/bench.XXXXXX") || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+# Best of RUNS wall times in seconds of lisp.out run with the given options and scripts,
+# counting what --time reports for its images and scripts rather than the process start.
+best_time() {
+    best_time_of "" "$@"
+}
+
+# Like best_time, counting only what --time reports for the first argument, a script or image
+# that the options and scripts after it name, so that scripts setting it up are left out.
+# Errors the scripts report go to stderr, since a script that fails early times as fast.
+best_time_of() {
+    timed=$1
+    shift
+    run=0
+    while [ "$run" -lt "$RUNS" ]; do
+        "$LISP" --time "$@" 2>&1 > /dev/null < /dev/null |
+            awk -v timed="$timed" '/: [0-9.]+s$/ && (timed == "" || index($0, timed ": ") == 1) {
+                sub(/s$/, "", $NF); total += $NF
+            } /^Error/ { print > "/dev/stderr" } END { printf "%.6f\n", total }'
+        run=$((run + 1))
+    done | sort -n | head -n 1
+}
+
+# One row of a report: what was measured, then the time in milliseconds.
+report() {
+    awk -v name="$1" -v seconds="$2" 'BEGIN { printf "%-44s %10.1f ms\n", name, seconds * 1000 }'
+}
+
+# Rows for the last of the scripts given, run after the others by the tree walker and by
+# --bytecode.
+report_engines() {
+    name=$1
+    shift
+    for timed; do :; done
+    report "$name, tree" "$(best_time_of "$timed" "$@")"
+    report "$name, bytecode" "$(best_time_of "$timed" --bytecode "$@")"
+}
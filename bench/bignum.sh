@@ -0,0 +1,22 @@
+#!/bin/sh
+# Integer arithmetic on both sides of the switch to big integers: fib FIB, whose numbers all
+# stay small ints and must not slow down for the big ones, and the factorials of each of
+# FACTORIALS, which grow into big integers of up to tens of thousands of digits.
+# usage: bench/bignum.sh [lisp.out]
+
+DIR=$(dirname "$0")
+LISP=${1:-build/lisp.out}
+. "$DIR/bench.sh"
+FIB=${FIB:-27}
+FACTORIALS=${FACTORIALS-1000 5000 20000}
+
+cat > "$WORK/setup.lisp" <<LISP
+(defun {fib n} {if (< n 2) {n} {+ (fib (- n 1)) (fib (- n 2))}})
+(defun {factorial n product} {if (== n 0) {product} {factorial (- n 1) (* product n)}})
+LISP
+echo "(def {result} (fib $FIB))" > "$WORK/fib.lisp"
+report_engines "fib $FIB" "$WORK/setup.lisp" "$WORK/fib.lisp"
+for n in $FACTORIALS; do
+    echo "(def {result} (factorial $n 1))" > "$WORK/factorial-$n.lisp"
+    report_engines "factorial $n" "$WORK/setup.lisp" "$WORK/factorial-$n.lisp"
+done
@@ -0,0 +1,36 @@
+# Writes about size megabytes of top-level Q-Expressions for the parse benchmark: nested lists
+# of symbols, numbers, floats and strings, as data files hold them. Each form evaluates to
+# itself, so loading the file costs little more than reading it.
+# usage: awk -v size=100 -f forms.awk > forms.lisp
+
+function item(depth,    kind) {
+    kind = next_random() % 8
+    if (kind == 0 && depth < 6) return list(depth + 1)
+    if (kind <= 2) return words[next_random() % 8]
+    if (kind <= 4) return next_random() - 16384
+    if (kind == 5) return next_random() "." next_random() % 100
+    return "\"" words[next_random() % 8] " " words[next_random() % 8] "\""
+}
+
+function list(depth,    count, text) {
+    text = "{" item(depth)
+    for (count = next_random() % 6 + 1; count > 0; count--) text = text " " item(depth)
+    return text "}"
+}
+
+# numbers below 32768, the same sequence with every awk, unlike rand
+function next_random() {
+    seed = (seed * 1103515245 + 12345) % 2147483648
+    return int(seed / 65536)
+}
+
+BEGIN {
+    split("alpha beta gamma-ray delta_x epsilon zeta* eta-theta iota", words, " ")
+    for (index_ = 1; index_ <= 8; index_++) words[index_ - 1] = words[index_]
+    seed = 42
+    limit = (size ? size : 100) * 1000000
+    for (written = 0; written < limit; written += length(form) + 1) {
+        form = "{record " list(0) " " list(0) "}"
+        print form
+    }
+}
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Throughput of --isolates: COUNT generated scripts, each defining and calling a few functions
+# of its own, run at once in isolates on each number of threads in THREADS, as scripts per
+# second, the best of RUNS.
+# usage: bench/isolates.sh [lisp.out]
+
+DIR=$(dirname "$0")
+LISP=${1:-build/lisp.out}
+. "$DIR/bench.sh"
+COUNT=${COUNT:-1000}
+THREADS=${THREADS:-1 2 4 8}
+
+awk -v count="$COUNT" -v work="$WORK" 'BEGIN {
+    for (index_ = 0; index_ < count; index_++) {
+        script = work "/script-" index_ ".lisp"
+        print "(defun {fib n} {if (< n 2) {n} {+ (fib (- n 1)) (fib (- n 2))}})" > script
+        print "(defun {upto n} {if (== n 0) {{}} {join (upto (- n 1)) (list n)}})" > script
+        print "(def {numbers} (upto " 100 + index_ % 50 "))" > script
+        print "(def {result} (list (fib " 12 + index_ % 4 ") (sum numbers) \"script-" index_ "\"))" > script
+        close(script)
+        printf "%s ", script
+    }
+}' > "$WORK/scripts"
+
+for threads in $THREADS; do
+    rate=$(run=0
+        while [ "$run" -lt "$RUNS" ]; do
+            "$LISP" --isolates --time --threads "$threads" $(cat "$WORK/scripts") 2>&1 > /dev/null < /dev/null |
+                awk '/ scripts on / { print $(NF - 1) }'
+            run=$((run + 1))
+        done | sort -n | tail -n 1)
+    awk -v count="$COUNT" -v threads="$threads" -v rate="$rate" 'BEGIN {
+        printf "%6d scripts on %d threads %12.1f scripts/s\n", count, threads, rate
+    }'
+done
@@ -0,0 +1,44 @@
+#!/bin/sh
+# Numeric kernels over argument lists of LENGTH numbers, ten thousand by default, CALLS times
+# each with --bytecode: +, -, * and < through the variadic operators, and sum and dot over a
+# Q-Expression and over a vector. `make bench` compares the SSE2 kernels with the scalar loops
+# of a build with LISP_SCALAR_KERNELS this way.
+# usage: bench/kernels.sh [lisp.out ...]
+
+DIR=$(dirname "$0")
+LISP=${1:-build/lisp.out}
+. "$DIR/bench.sh"
+LENGTH=${LENGTH:-10000}
+CALLS=${CALLS:-2000}
+
+awk -v length_="$LENGTH" 'BEGIN {
+    for (index_ = 1; index_ <= length_; index_++) {
+        numbers = numbers " " index_ % 1000
+        ones = ones " 1"
+        ascending = ascending " " index_
+    }
+    print "(defun {times n f} {if (== n 0) {n} {do {f ()} {times (- n 1) f}}})"
+    print "(def {numbers} {" substr(numbers, 2) "})"
+    print "(def {packed} (to-vector numbers))"
+    print "(defun {add _} {+" numbers "})"
+    print "(defun {subtract _} {-" numbers "})"
+    print "(defun {multiply _} {*" ones "})"
+    print "(defun {less _} {<" ascending "})"
+    print "(defun {sum-list _} {sum numbers})"
+    print "(defun {sum-vector _} {sum packed})"
+    print "(defun {dot-list _} {dot numbers numbers})"
+    print "(defun {dot-vector _} {dot packed packed})"
+}' > "$WORK/setup.lisp"
+cases="add subtract multiply less sum-list sum-vector dot-list dot-vector"
+for case in $cases; do echo "(def {result} (times $CALLS $case))" > "$WORK/$case.lisp"; done
+
+[ $# -eq 0 ] && set -- "$LISP"
+for LISP in "$@"; do
+    echo "$LISP"
+    for case in $cases; do
+        seconds=$(best_time_of "$WORK/$case.lisp" --bytecode "$WORK/setup.lisp" "$WORK/$case.lisp")
+        awk -v name="$case" -v seconds="$seconds" -v count="$((LENGTH * CALLS))" 'BEGIN {
+            printf "  %-12s %10.1f ms %8.2f ns per number\n", name, seconds * 1000, seconds * 1e9 / count
+        }'
+    done
+done
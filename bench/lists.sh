@@ -0,0 +1,24 @@
+#!/bin/sh
+# Recursive walks over lists of LENGTH elements, a million by default, which take time linear
+# in the length only while head, tail and cons share the list rather than copy it: a sum over
+# nth and tail, a list built by cons, and the same walk over lists joined from halves.
+# usage: bench/lists.sh [lisp.out]
+
+DIR=$(dirname "$0")
+LISP=${1:-build/lisp.out}
+. "$DIR/bench.sh"
+LENGTH=${LENGTH:-1000000}
+
+cat > "$WORK/setup.lisp" <<LISP
+(def {numbers} (to-list (range 0 $LENGTH)))
+(defun {walk xs total} {if (== xs {}) {total} {walk (tail xs) (+ total (nth xs 0))}})
+(defun {build n xs} {if (== n 0) {xs} {build (- n 1) (cons n xs)}})
+LISP
+echo "(def {total} (walk numbers 0))" > "$WORK/walk.lisp"
+echo "(def {built} (build $LENGTH {}))" > "$WORK/cons.lisp"
+echo "(def {total} (walk (join (slice numbers 0 $((LENGTH / 2))) (slice numbers $((LENGTH / 2)) $LENGTH)) 0))" \
+    > "$WORK/join.lisp"
+
+for case in walk cons join; do
+    report_engines "$case $LENGTH" "$WORK/setup.lisp" "$WORK/$case.lisp"
+done
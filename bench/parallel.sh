@@ -0,0 +1,30 @@
+#!/bin/sh
+# Scaling of pmap, pfilter and preduce over a list of LENGTH numbers, each element or combination
+# costing a small recursive call, on each number of threads in THREADS, with the speed-up over
+# the first of them.
+# usage: bench/parallel.sh [lisp.out]
+
+DIR=$(dirname "$0")
+LISP=${1:-build/lisp.out}
+. "$DIR/bench.sh"
+LENGTH=${LENGTH:-5000}
+THREADS=${THREADS:-1 2 4 8}
+
+cat > "$WORK/setup.lisp" <<LISP
+(defun {fib n} {if (< n 2) {n} {+ (fib (- n 1)) (fib (- n 2))}})
+(defun {work x} {+ x (fib (+ 8 (% x 4)))})
+(def {numbers} (to-list (range 0 $LENGTH)))
+LISP
+echo "(def {result} (pmap work numbers))" > "$WORK/pmap.lisp"
+echo "(def {result} (pfilter (lambda {x} {% (work x) 2}) numbers))" > "$WORK/pfilter.lisp"
+echo "(def {result} (preduce (lambda {x y} {+ x y (% (fib 10) 1)}) numbers))" > "$WORK/preduce.lisp"
+
+for case in pmap pfilter preduce; do
+    for threads in $THREADS; do
+        seconds=$(best_time_of "$WORK/$case.lisp" --threads "$threads" "$WORK/setup.lisp" "$WORK/$case.lisp")
+        [ "$threads" = "${THREADS%% *}" ] && first=$seconds
+        awk -v name="$case $LENGTH, $threads threads" -v seconds="$seconds" -v first="$first" 'BEGIN {
+            printf "%-44s %10.1f ms %6.2fx\n", name, seconds * 1000, first / seconds
+        }'
+    done
+done
@@ -0,0 +1,40 @@
+#!/bin/sh
+# Reading throughput of each interpreter given, in MB/s: SIZE megabytes of generated data
+# forms, one form of lists nested DEPTH deep, and SIZE megabytes of forms with long runs of
+# blanks and symbol characters, each loaded from a file. `make bench` compares the reader with
+# and without its SSE2 scanners this way.
+# usage: bench/parse.sh [lisp.out ...]
+
+DIR=$(dirname "$0")
+LISP=${1:-build/lisp.out}
+. "$DIR/bench.sh"
+SIZE=${SIZE:-100}
+DEPTH=${DEPTH:-1000000}
+
+awk -v size="$SIZE" -f "$DIR/forms.awk" > "$WORK/forms.lisp"
+awk -v depth="$DEPTH" 'BEGIN {
+    opening = "{"; closing = "}"
+    while (length(opening) < depth) { opening = opening opening; closing = closing closing }
+    print substr(opening, 1, depth) "x" substr(closing, 1, depth)
+}' > "$WORK/nested.lisp"
+awk -v size="$SIZE" 'BEGIN {
+    blanks = "                                        "
+    for (written = 0; written < size * 1000000; written += length(form) + 1) {
+        form = "{" blanks "long-symbol-of-some-record-" written blanks "{another-long-symbol-name " \
+            written * 7 " -" written "}}"
+        print form
+    }
+}' > "$WORK/runs.lisp"
+for input in forms nested runs; do echo "(load \"$WORK/$input.lisp\")" > "$WORK/load-$input.lisp"; done
+
+[ $# -eq 0 ] && set -- "$LISP"
+for LISP in "$@"; do
+    echo "$LISP"
+    for input in forms nested runs; do
+        seconds=$(best_time "$WORK/load-$input.lisp")
+        bytes=$(wc -c < "$WORK/$input.lisp")
+        awk -v name="$input" -v bytes="$bytes" -v seconds="$seconds" 'BEGIN {
+            printf "  %-10s %8.1f MB in %8.3f s %8.1f MB/s\n", name, bytes / 1e6, seconds, bytes / 1e6 / seconds
+        }'
+    done
+done
@@ -0,0 +1,23 @@
+# Writes a prelude of count definitions for the startup benchmark: functions of one to three
+# parameters whose bodies call the functions defined before them, and constant lists, the way a
+# library of helpers builds on itself. Defining them is what a start costs: the benchmark calls
+# just one.
+# usage: awk -v count=10000 -f prelude.awk > prelude.lisp
+
+BEGIN {
+    for (index_ = 0; index_ < count; index_++) {
+        previous = "fn-" (index_ > 0 ? index_ - 1 : 0)
+        kind = index_ % 5
+        if (kind == 0) {
+            print "(defun {fn-" index_ " x} {+ x " index_ "})"
+        } else if (kind == 1) {
+            print "(defun {fn-" index_ " x y} {if (< x y) {" previous " x} {* y " index_ "}})"
+        } else if (kind == 2) {
+            print "(def {fn-" index_ "} (lambda {x} {do {def {seen} x} {" previous " (- x 1) x}}))"
+        } else if (kind == 3) {
+            print "(defun {fn-" index_ " x y z} {list (" previous " x) (+ y z) \"fn-" index_ "\"})"
+        } else {
+            print "(def {fn-" index_ "} {" index_ " " index_ ".5 {key-" index_ " \"value\"} fn-" index_ - 1 "})"
+        }
+    }
+}
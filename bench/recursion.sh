@@ -0,0 +1,29 @@
+#!/bin/sh
+# Call cost in deep recursion: fib FIB, ackermann 2 ACK, and a loop of LOOP calls to a function
+# partially applied to eight arguments, which costs as much per call as an unbound one only when
+# a call frame links to the bindings of its closure instead of copying them.
+# usage: bench/recursion.sh [lisp.out]
+
+DIR=$(dirname "$0")
+LISP=${1:-build/lisp.out}
+. "$DIR/bench.sh"
+FIB=${FIB:-25}
+ACK=${ACK:-500}
+LOOP=${LOOP:-300000}
+
+cat > "$WORK/setup.lisp" <<LISP
+(defun {fib n} {if (< n 2) {n} {+ (fib (- n 1)) (fib (- n 2))}})
+(defun {ack m n} {if (== m 0) {+ n 1} {if (== n 0) {ack (- m 1) 1} {ack (- m 1) (ack m (- n 1))}}})
+(defun {wide a b c d e f g h x} {if (== x 0) {a} {bound (- x 1)}})
+(defun {narrow x} {if (== x 0) {x} {narrow (- x 1)}})
+(def {bound} (wide 1 2 3 4 5 6 7 8))
+LISP
+echo "(def {result} (fib $FIB))" > "$WORK/fib.lisp"
+echo "(def {result} (ack 2 $ACK))" > "$WORK/ack.lisp"
+echo "(def {result} (bound $LOOP))" > "$WORK/partial.lisp"
+echo "(def {result} (narrow $LOOP))" > "$WORK/unbound.lisp"
+
+report_engines "fib $FIB" "$WORK/setup.lisp" "$WORK/fib.lisp"
+report_engines "ack 2 $ACK" "$WORK/setup.lisp" "$WORK/ack.lisp"
+report_engines "$LOOP calls, 8 arguments bound" "$WORK/setup.lisp" "$WORK/partial.lisp"
+report_engines "$LOOP calls, none bound" "$WORK/setup.lisp" "$WORK/unbound.lisp"
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Start-up cost of a prelude of COUNT definitions, read and evaluated from source against loaded
+# from an image that save-image wrote from it, with either engine, before a script that calls one
+# of them. The wall rows time the whole process, start and exit included.
+# usage: bench/startup.sh [lisp.out]
+
+DIR=$(dirname "$0")
+LISP=${1:-build/lisp.out}
+. "$DIR/bench.sh"
+COUNT=${COUNT:-10000}
+
+last=$((COUNT - 1))
+awk -v count="$COUNT" -f "$DIR/prelude.awk" > "$WORK/prelude.lisp"
+echo "(save-image \"$WORK/prelude.image\")" > "$WORK/save.lisp"
+echo "(fn-$last)" > "$WORK/main.lisp"
+"$LISP" "$WORK/prelude.lisp" "$WORK/save.lisp" < /dev/null || exit 1
+
+# Best of RUNS wall times in seconds of the whole lisp.out process.
+best_wall() {
+    run=0
+    while [ "$run" -lt "$RUNS" ]; do
+        start=$(date +%s%N)
+        "$LISP" "$@" > /dev/null 2>&1 < /dev/null
+        echo $(($(date +%s%N) - start))
+        run=$((run + 1))
+    done | sort -n | head -n 1 | awk '{ printf "%.6f\n", $1 / 1e9 }'
+}
+
+echo "$COUNT definitions, $(wc -c < "$WORK/prelude.lisp") bytes of source," \
+    "$(wc -c < "$WORK/prelude.image") bytes of image"
+for engine in "" --bytecode; do
+    name=${engine:-tree}
+    name=${name#--}
+    report "$name: prelude from source" "$(best_time $engine "$WORK/prelude.lisp" "$WORK/main.lisp")"
+    report "$name: prelude from image" "$(best_time $engine --image "$WORK/prelude.image" "$WORK/main.lisp")"
+    report "$name: wall, prelude from source" "$(best_wall $engine "$WORK/prelude.lisp" "$WORK/main.lisp")"
+    report "$name: wall, prelude from image" "$(best_wall $engine --image "$WORK/prelude.image" "$WORK/main.lisp")"
+done
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Symbol-heavy work, COUNT times each: case dispatch on symbols, equality of lists of symbols,
+# lookups of many distinct globals, and reading a file of COUNT distinct symbols, which interns
+# each of them once.
+# usage: bench/symbols.sh [lisp.out]
+
+DIR=$(dirname "$0")
+LISP=${1:-build/lisp.out}
+. "$DIR/bench.sh"
+COUNT=${COUNT:-200000}
+
+awk 'BEGIN {
+    print "(def {ops} {add sub mul div mod pow min max})"
+    print "(defun {dispatch op x} {case op {add {+ x 1}} {sub {- x 1}} {mul {* x 2}} {div {/ x 2}} " \
+        "{mod {% x 7}} {pow {^ x 1}} {min {x}} {otherwise {0}}})"
+    print "(defun {dispatches n} {if (== n 0) {n} {do {dispatch (nth ops (% n 8)) n} {dispatches (- n 1)}}})"
+    print "(def {names} {alpha beta gamma delta epsilon zeta eta theta iota kappa lambda-x mu nu xi})"
+    print "(defun {compares n} {if (== n 0) {n} {do {== names {alpha beta gamma delta epsilon zeta eta " \
+        "theta iota kappa lambda-x mu nu xi}} {compares (- n 1)}}})"
+    body = "0"
+    for (index_ = 0; index_ < 16; index_++) {
+        print "(def {global-" index_ "} " index_ ")"
+        body = "(+ global-" index_ " " body ")"
+    }
+    print "(defun {lookups n} {if (== n 0) {n} {do {" body "} {lookups (- n 1)}}})"
+}' > "$WORK/setup.lisp"
+echo "(def {result} (dispatches $COUNT))" > "$WORK/case.lisp"
+echo "(def {result} (compares $COUNT))" > "$WORK/equal.lisp"
+echo "(def {result} (lookups $((COUNT / 10))))" > "$WORK/lookup.lisp"
+awk -v count="$COUNT" 'BEGIN {
+    for (index_ = 0; index_ < count; index_++) print "{symbol-" index_ " symbol-" index_ " shared}"
+}' > "$WORK/symbols.lisp"
+
+report_engines "case on symbols, $COUNT" "$WORK/setup.lisp" "$WORK/case.lisp"
+report_engines "== on lists of 14 symbols, $COUNT" "$WORK/setup.lisp" "$WORK/equal.lisp"
+report_engines "16 global lookups, $((COUNT / 10))" "$WORK/setup.lisp" "$WORK/lookup.lisp"
+report_engines "read $COUNT distinct symbols" "$WORK/symbols.lisp"
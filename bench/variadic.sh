@@ -0,0 +1,21 @@
+#!/bin/sh
+# Built-in calls over long argument lists: +, * and < applied to ARGUMENTS literal numbers,
+# CALLS times each, which is mostly the cost of dispatching to the built-in and folding its
+# arguments.
+# usage: bench/variadic.sh [lisp.out]
+
+DIR=$(dirname "$0")
+LISP=${1:-build/lisp.out}
+. "$DIR/bench.sh"
+ARGUMENTS=${ARGUMENTS:-1000}
+CALLS=${CALLS:-20000}
+
+for operator in + "*" "<"; do
+    awk -v operator="$operator" -v arguments="$ARGUMENTS" -v calls="$CALLS" 'BEGIN {
+        call = operator
+        for (index_ = 1; index_ <= arguments; index_++) call = call " " (operator == "*" ? 1 : index_)
+        print "(defun {calls n} {if (== n 0) {n} {do {" call "} {calls (- n 1)}}})"
+        print "(def {result} (calls " calls "))"
+    }' > "$WORK/calls.lisp"
+    report_engines "($operator ...) of $ARGUMENTS, $CALLS times" "$WORK/calls.lisp"
+done
@@ -0,0 +1,46 @@
+#include "allocation.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+static thread_local size_t allocation_count = 0;
+static thread_local size_t thread_folded_count = 0;
+static std::atomic<size_t> folded_count(0);
+
+
+size_t heap_allocations() {
+    return folded_count.load() + allocation_count;
+}
+
+void fold_thread_allocations() {
+    folded_count += allocation_count;
+    thread_folded_count += allocation_count;
+    allocation_count = 0;
+}
+
+size_t thread_heap_allocations() {
+    return thread_folded_count + allocation_count;
+}
+
+
+/* replaces the global allocation functions so that every allocation is counted */
+void* operator new(size_t size) {
+    allocation_count++;
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
@@ -0,0 +1,18 @@
+#ifndef _ALLOCATION_HPP_
+#define _ALLOCATION_HPP_
+
+
+#include <cstddef>
+
+
+// Heap allocations made through operator new since the start of the program, by the calling
+// thread and by the ones that have folded theirs in.
+size_t heap_allocations();
+
+// Adds the allocations of the calling thread to the ones of the others, which are counted apart.
+void fold_thread_allocations();
+
+// Heap allocations made by the calling thread since it started, folded or not.
+size_t thread_heap_allocations();
+
+#endif  // _ALLOCATION_HPP_
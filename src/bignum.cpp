@@ -0,0 +1,379 @@
+#include "bignum.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+using limbs = std::vector<uint32_t>;
+
+static const uint64_t limb_base = uint64_t(1) << 32;
+static const uint32_t decimal_base = 1000000000;    // largest power of ten in a limb
+static const size_t decimal_digits = 9;
+
+/* below this many limbs in either factor, the schoolbook product is the faster one */
+static const size_t karatsuba_threshold = 32;
+
+
+inline void trim(limbs& magnitude);
+inline int compare_magnitudes(const limbs& x, const limbs& y);
+inline limbs add_magnitudes(const uint32_t* x, size_t x_size, const uint32_t* y, size_t y_size);
+inline limbs subtract_magnitudes(const limbs& x, const limbs& y);
+inline limbs multiply_magnitudes(const uint32_t* x, size_t x_size, const uint32_t* y, size_t y_size);
+inline void multiply_schoolbook(
+    const uint32_t* x, size_t x_size, const uint32_t* y, size_t y_size, uint32_t* product);
+inline void add_shifted(limbs& x, const limbs& y, size_t shift);
+inline void multiply_add_limb(limbs& x, uint32_t factor, uint32_t addend);
+inline uint32_t divide_by_limb(limbs& x, uint32_t divisor);
+inline void divide_magnitudes(const limbs& x, const limbs& y, limbs& quotient, limbs& remainder);
+
+
+LispBigInteger::LispBigInteger(int64_t value):
+_is_negative(value < 0),
+_magnitude()
+{
+    uint64_t magnitude = _is_negative ? uint64_t(0) - static_cast<uint64_t>(value) : value;
+    for (; magnitude; magnitude >>= 32) _magnitude.push_back(static_cast<uint32_t>(magnitude));
+}
+
+LispBigInteger::LispBigInteger(const std::string& digits):
+_is_negative(),
+_magnitude()
+{
+    const size_t digits_begin = digits[0] == '-' || digits[0] == '+' ? 1 : 0;
+
+    /* nine digits at a time, the first chunk taking whatever is left over */
+    size_t index = digits_begin;
+    size_t chunk = (digits.length() - digits_begin) % decimal_digits;
+    if (chunk == 0) chunk = decimal_digits;
+    while (index < digits.length()) {
+        uint32_t value = 0, factor = 1;
+        for (size_t end = index + chunk; index < end; index++) {
+            value = value * 10 + (digits[index] - '0');
+            factor *= 10;
+        }
+        multiply_add_limb(_magnitude, factor, value);
+        chunk = decimal_digits;
+    }
+    _is_negative = digits[0] == '-' && !_magnitude.empty();
+}
+
+LispBigInteger::LispBigInteger(bool is_negative, limbs&& magnitude):
+_is_negative(),
+_magnitude(std::move(magnitude))
+{
+    trim(_magnitude);
+    _is_negative = is_negative && !_magnitude.empty();
+}
+
+bool LispBigInteger::fits_int() const {
+    if (_magnitude.size() > 1) return false;
+    const uint32_t magnitude = _magnitude.empty() ? 0 : _magnitude[0];
+    return magnitude <= (_is_negative ? uint32_t(1) << 31 : (uint32_t(1) << 31) - 1);
+}
+
+int LispBigInteger::to_int() const {
+    const int64_t magnitude = _magnitude.empty() ? 0 : _magnitude[0];
+    return static_cast<int>(_is_negative ? -magnitude : magnitude);
+}
+
+double LispBigInteger::to_double() const {
+    const size_t size = _magnitude.size();
+    if (size <= 2) {
+        const uint64_t magnitude = size == 0 ? 0 : size == 1 ? _magnitude[0]
+            : (uint64_t(_magnitude[1]) << 32) | _magnitude[0];
+        return _is_negative ? -static_cast<double>(magnitude) : static_cast<double>(magnitude);
+    }
+
+    /* the top 64 bits, with a sticky bit for any nonzero bit below them, round once and correctly */
+    const int leading = __builtin_clz(_magnitude[size - 1]);
+    const unsigned __int128 top_limbs = (static_cast<unsigned __int128>(_magnitude[size - 1]) << 64)
+        | (uint64_t(_magnitude[size - 2]) << 32) | _magnitude[size - 3];
+    const unsigned __int128 shifted = top_limbs << leading;
+    bool is_inexact = static_cast<uint32_t>(shifted) != 0;
+    for (size_t index = 0; index + 3 < size && !is_inexact; index++) is_inexact = _magnitude[index] != 0;
+
+    const uint64_t top = static_cast<uint64_t>(shifted >> 32) | (is_inexact ? 1 : 0);
+    const double magnitude = std::ldexp(static_cast<double>(top), static_cast<int>(32 * (size - 2)) - leading);
+    return _is_negative ? -magnitude : magnitude;
+}
+
+std::string LispBigInteger::to_string() const {
+    if (_magnitude.empty()) return "0";
+
+    std::vector<uint32_t> chunks;
+    limbs magnitude(_magnitude);
+    while (!magnitude.empty()) {
+        chunks.push_back(divide_by_limb(magnitude, decimal_base));
+        trim(magnitude);
+    }
+
+    std::string result(_is_negative ? "-" : "");
+    result += std::to_string(chunks.back());
+    for (size_t index = chunks.size() - 1; index > 0; index--) {
+        const std::string chunk(std::to_string(chunks[index - 1]));
+        result.append(decimal_digits - chunk.length(), '0');
+        result += chunk;
+    }
+    return result;
+}
+
+LispBigInteger LispBigInteger::operator-() const {
+    LispBigInteger result(*this);
+    result._is_negative = !_is_negative && !_magnitude.empty();
+    return result;
+}
+
+LispBigInteger LispBigInteger::pow(unsigned int exponent) const {
+    LispBigInteger result(1), base(*this);
+    while (exponent) {
+        if (exponent & 1) result = result * base;
+        exponent >>= 1;
+        if (exponent) base = base * base;
+    }
+    return result;
+}
+
+int compare(const LispBigInteger& x, const LispBigInteger& y) {
+    if (x._is_negative != y._is_negative) return x._is_negative ? -1 : 1;
+    const int order = compare_magnitudes(x._magnitude, y._magnitude);
+    return x._is_negative ? -order : order;
+}
+
+LispBigInteger operator+(const LispBigInteger& x, const LispBigInteger& y) {
+    if (x._is_negative == y._is_negative) {
+        return LispBigInteger(x._is_negative, add_magnitudes(
+            x._magnitude.data(), x._magnitude.size(), y._magnitude.data(), y._magnitude.size()));
+    }
+    /* the sign is the one of the larger magnitude, from which the smaller one is taken */
+    if (compare_magnitudes(x._magnitude, y._magnitude) >= 0) {
+        return LispBigInteger(x._is_negative, subtract_magnitudes(x._magnitude, y._magnitude));
+    }
+    return LispBigInteger(y._is_negative, subtract_magnitudes(y._magnitude, x._magnitude));
+}
+
+LispBigInteger operator-(const LispBigInteger& x, const LispBigInteger& y) {
+    return x + -y;
+}
+
+LispBigInteger operator*(const LispBigInteger& x, const LispBigInteger& y) {
+    return LispBigInteger(x._is_negative != y._is_negative, multiply_magnitudes(
+        x._magnitude.data(), x._magnitude.size(), y._magnitude.data(), y._magnitude.size()));
+}
+
+LispBigInteger operator/(const LispBigInteger& x, const LispBigInteger& y) {
+    limbs quotient, remainder;
+    divide_magnitudes(x._magnitude, y._magnitude, quotient, remainder);
+    return LispBigInteger(x._is_negative != y._is_negative, std::move(quotient));
+}
+
+LispBigInteger operator%(const LispBigInteger& x, const LispBigInteger& y) {
+    limbs quotient, remainder;
+    divide_magnitudes(x._magnitude, y._magnitude, quotient, remainder);
+    return LispBigInteger(x._is_negative, std::move(remainder));
+}
+
+
+inline void trim(limbs& magnitude) {
+    while (!magnitude.empty() && magnitude.back() == 0) magnitude.pop_back();
+}
+
+inline int compare_magnitudes(const limbs& x, const limbs& y) {
+    if (x.size() != y.size()) return x.size() < y.size() ? -1 : 1;
+    for (size_t index = x.size(); index > 0; index--) {
+        if (x[index - 1] != y[index - 1]) return x[index - 1] < y[index - 1] ? -1 : 1;
+    }
+    return 0;
+}
+
+inline limbs add_magnitudes(const uint32_t* x, size_t x_size, const uint32_t* y, size_t y_size) {
+    if (x_size < y_size) {
+        std::swap(x, y);
+        std::swap(x_size, y_size);
+    }
+    limbs sum(x_size + 1);
+    uint64_t carry = 0;
+    for (size_t index = 0; index < x_size; index++) {
+        carry += static_cast<uint64_t>(x[index]) + (index < y_size ? y[index] : 0);
+        sum[index] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    sum[x_size] = static_cast<uint32_t>(carry);
+    trim(sum);
+    return sum;
+}
+
+inline limbs subtract_magnitudes(const limbs& x, const limbs& y) {
+    /* x is at least as large as y */
+    limbs difference(x.size());
+    int64_t borrow = 0;
+    for (size_t index = 0; index < x.size(); index++) {
+        const int64_t limb = static_cast<int64_t>(x[index]) - (index < y.size() ? y[index] : 0) - borrow;
+        borrow = limb < 0;
+        difference[index] = static_cast<uint32_t>(limb + (borrow ? limb_base : 0));
+    }
+    trim(difference);
+    return difference;
+}
+
+inline limbs multiply_magnitudes(const uint32_t* x, size_t x_size, const uint32_t* y, size_t y_size) {
+    while (x_size && x[x_size - 1] == 0) x_size--;
+    while (y_size && y[y_size - 1] == 0) y_size--;
+    if (x_size == 0 || y_size == 0) return limbs();
+    if (x_size < karatsuba_threshold || y_size < karatsuba_threshold) {
+        limbs product(x_size + y_size);
+        multiply_schoolbook(x, x_size, y, y_size, product.data());
+        trim(product);
+        return product;
+    }
+
+    /* with x = x1 B + x0 and y = y1 B + y0, x1 y0 + x0 y1 comes from one product rather than two */
+    const size_t half = std::max(x_size, y_size) / 2;
+    const size_t x_low = std::min(x_size, half), y_low = std::min(y_size, half);
+    const limbs low(multiply_magnitudes(x, x_low, y, y_low));
+    const limbs high(multiply_magnitudes(x + x_low, x_size - x_low, y + y_low, y_size - y_low));
+    const limbs x_sum(add_magnitudes(x, x_low, x + x_low, x_size - x_low));
+    const limbs y_sum(add_magnitudes(y, y_low, y + y_low, y_size - y_low));
+    const limbs middle(subtract_magnitudes(subtract_magnitudes(
+        multiply_magnitudes(x_sum.data(), x_sum.size(), y_sum.data(), y_sum.size()), low), high));
+
+    limbs product(x_size + y_size);
+    add_shifted(product, low, 0);
+    add_shifted(product, middle, half);
+    add_shifted(product, high, 2 * half);
+    trim(product);
+    return product;
+}
+
+inline void multiply_schoolbook(
+    const uint32_t* x, size_t x_size, const uint32_t* y, size_t y_size, uint32_t* product
+) {
+    /* a limb times a limb plus two limbs always fits in 64 bits */
+    for (size_t i = 0; i < x_size; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < y_size; j++) {
+            carry += static_cast<uint64_t>(x[i]) * y[j] + product[i + j];
+            product[i + j] = static_cast<uint32_t>(carry);
+            carry >>= 32;
+        }
+        product[i + y_size] = static_cast<uint32_t>(carry);
+    }
+}
+
+inline void add_shifted(limbs& x, const limbs& y, size_t shift) {
+    /* x has room for the sum */
+    uint64_t carry = 0;
+    size_t index = 0;
+    for (; index < y.size(); index++) {
+        carry += static_cast<uint64_t>(x[index + shift]) + y[index];
+        x[index + shift] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    for (; carry; index++) {
+        carry += x[index + shift];
+        x[index + shift] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+}
+
+inline void multiply_add_limb(limbs& x, uint32_t factor, uint32_t addend) {
+    uint64_t carry = addend;
+    for (uint32_t& limb : x) {
+        carry += static_cast<uint64_t>(limb) * factor;
+        limb = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    if (carry) x.push_back(static_cast<uint32_t>(carry));
+}
+
+inline uint32_t divide_by_limb(limbs& x, uint32_t divisor) {
+    uint64_t remainder = 0;
+    for (size_t index = x.size(); index > 0; index--) {
+        const uint64_t dividend = remainder << 32 | x[index - 1];
+        x[index - 1] = static_cast<uint32_t>(dividend / divisor);
+        remainder = dividend % divisor;
+    }
+    return static_cast<uint32_t>(remainder);
+}
+
+inline void divide_magnitudes(const limbs& x, const limbs& y, limbs& quotient, limbs& remainder) {
+    if (y.empty()) {
+        throw std::invalid_argument("Error: zero division is invalid");
+    }
+    if (compare_magnitudes(x, y) < 0) {
+        quotient.clear();
+        remainder = x;
+        return;
+    }
+    if (y.size() == 1) {
+        quotient = x;
+        const uint32_t rest = divide_by_limb(quotient, y[0]);
+        trim(quotient);
+        remainder.assign(rest ? 1 : 0, rest);
+        return;
+    }
+
+    /*
+     * Knuth's algorithm D: with the divisor shifted until its top bit is set, a quotient limb
+     * guessed from the top two limbs of the dividend and the top one of the divisor is at most
+     * two too large, which the top two limbs of the divisor mostly tell right away.
+     */
+    const size_t n = y.size(), m = x.size();
+    const int shift = __builtin_clz(y.back());
+    limbs divisor(n), dividend(m + 1);
+    for (size_t index = n - 1; index > 0; index--) {
+        divisor[index] = y[index] << shift | (shift ? static_cast<uint64_t>(y[index - 1]) >> (32 - shift) : 0);
+    }
+    divisor[0] = y[0] << shift;
+    dividend[m] = shift ? static_cast<uint64_t>(x[m - 1]) >> (32 - shift) : 0;
+    for (size_t index = m - 1; index > 0; index--) {
+        dividend[index] = x[index] << shift | (shift ? static_cast<uint64_t>(x[index - 1]) >> (32 - shift) : 0);
+    }
+    dividend[0] = x[0] << shift;
+
+    quotient.assign(m - n + 1, 0);
+    for (size_t j = m - n + 1; j-- > 0;) {
+        const uint64_t top = static_cast<uint64_t>(dividend[j + n]) << 32 | dividend[j + n - 1];
+        uint64_t guess = top / divisor[n - 1];
+        uint64_t rest = top % divisor[n - 1];
+        while (
+            guess >= limb_base ||
+            guess * divisor[n - 2] > (rest << 32 | dividend[j + n - 2])
+        ) {
+            guess--;
+            rest += divisor[n - 1];
+            if (rest >= limb_base) break;
+        }
+
+        /* subtract guess times the divisor, and add it back once if that went below zero */
+        int64_t borrow = 0, difference;
+        for (size_t i = 0; i < n; i++) {
+            const uint64_t product = guess * divisor[i];
+            difference = static_cast<int64_t>(dividend[i + j]) - borrow - static_cast<int64_t>(product & 0xffffffff);
+            dividend[i + j] = static_cast<uint32_t>(difference);
+            borrow = static_cast<int64_t>(product >> 32) - (difference >> 32);
+        }
+        difference = static_cast<int64_t>(dividend[j + n]) - borrow;
+        dividend[j + n] = static_cast<uint32_t>(difference);
+
+        quotient[j] = static_cast<uint32_t>(guess);
+        if (difference < 0) {
+            quotient[j]--;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                carry += static_cast<uint64_t>(dividend[i + j]) + divisor[i];
+                dividend[i + j] = static_cast<uint32_t>(carry);
+                carry >>= 32;
+            }
+            dividend[j + n] += static_cast<uint32_t>(carry);
+        }
+    }
+    trim(quotient);
+
+    remainder.assign(n, 0);
+    for (size_t index = 0; index < n; index++) {
+        remainder[index] = dividend[index] >> shift |
+            (shift ? static_cast<uint32_t>(static_cast<uint64_t>(dividend[index + 1]) << (32 - shift)) : 0);
+    }
+    trim(remainder);
+}
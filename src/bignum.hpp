@@ -0,0 +1,54 @@
+#ifndef _BIGNUM_HPP_
+#define _BIGNUM_HPP_
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Integer of any size, as a sign and a magnitude of 32-bit limbs from the least significant one.
+// The magnitude never has leading zero limbs, and zero is never negative.
+class LispBigInteger {
+    public:
+        LispBigInteger(): _is_negative(), _magnitude() {}
+        explicit LispBigInteger(int64_t value);
+
+        // decimal digits after an optional sign, which are expected to be valid
+        explicit LispBigInteger(const std::string& digits);
+
+        LispBigInteger(bool is_negative, std::vector<uint32_t>&& magnitude);
+
+        bool is_zero() const { return _magnitude.empty(); }
+        bool is_negative() const { return _is_negative; }
+        const std::vector<uint32_t>& magnitude() const { return _magnitude; }
+
+        bool fits_int() const;
+        int to_int() const;
+        double to_double() const;   // rounded to the nearest double, or infinite
+        std::string to_string() const;
+
+        LispBigInteger operator-() const;
+        LispBigInteger pow(unsigned int exponent) const;
+
+        // -1, 0 or 1 as x is less than, equal to or greater than y
+        friend int compare(const LispBigInteger& x, const LispBigInteger& y);
+
+        friend LispBigInteger operator+(const LispBigInteger& x, const LispBigInteger& y);
+        friend LispBigInteger operator-(const LispBigInteger& x, const LispBigInteger& y);
+        friend LispBigInteger operator*(const LispBigInteger& x, const LispBigInteger& y);
+
+        // quotient rounded toward zero and remainder with the sign of x, as for int
+        friend LispBigInteger operator/(const LispBigInteger& x, const LispBigInteger& y);
+        friend LispBigInteger operator%(const LispBigInteger& x, const LispBigInteger& y);
+
+    private:
+        bool _is_negative;
+        std::vector<uint32_t> _magnitude;
+};
+
+inline bool operator==(const LispBigInteger& x, const LispBigInteger& y) {
+    return x.is_negative() == y.is_negative() && x.magnitude() == y.magnitude();
+}
+
+#endif  // _BIGNUM_HPP_
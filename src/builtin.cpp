@@ -1,98 +1,207 @@
 #include "builtin.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include "allocation.hpp"
 #include "evaluation.hpp"
-
-
-inline LispValue _operator(
-    std::vector<LispValue>& evaluated_arguments,
-    const std::function<int(int)>& unary_op,
-    const std::function<int(int, int)>& binary_op,
-    const std::string& name
-);
-inline LispValue _operator(
-    std::vector<LispValue>& evaluated_arguments,
-    const std::function<int(int, int)>& binary_op,
-    const std::string& name
-);
-inline LispValue _operator(
-    std::vector<LispValue>& evaluated_arguments,
-    const std::function<int(int)>& unary_op,
-    const std::string& name
-);
-inline LispValue _relation(
-    std::vector<LispValue>& evaluated_arguments,
-    const std::function<int(int, int)>& relation,
-    const std::string& name
-);
+#include "image.hpp"
+#include "memo.hpp"
+#include "numeric.hpp"
+#include "parallel.hpp"
+#include "profile.hpp"
+#include "script.hpp"
+
+
+using LispBigOperation = LispBigInteger (*)(const LispBigInteger&, const LispBigInteger&);
+using LispRealOperation = double (*)(double, double);
+
+static const size_t default_memo_capacity = 4096;     // results a memoized function remembers
+static const long long max_range_length = 1LL << 27;   // numbers a range makes, 512 MB of them
+
+inline LispValue _sum(std::vector<LispValue>& evaluated_arguments, bool is_subtraction, const char* name);
+template <bool (*binary_op)(int, int, int&), LispBigOperation big_op, LispRealOperation real_op>
+inline LispValue _operator(std::vector<LispValue>& evaluated_arguments, const char* name);
+template <int (*unary_op)(int)>
+inline LispValue _operator(std::vector<LispValue>& evaluated_arguments, const char* name);
+template <LispBigOperation big_op>
+inline LispValue _big_operator(std::vector<LispValue>& evaluated_arguments, size_t from, LispBigInteger&& result);
+template <LispRealOperation real_op>
+inline LispValue _real_operator(std::vector<LispValue>& evaluated_arguments, size_t from, double result);
+inline LispValue _relation(std::vector<LispValue>& evaluated_arguments, LispOrder order, const char* name);
+inline LispValue _packed_sum(std::vector<LispValue>& evaluated_arguments, bool is_subtraction, const char* name);
+template <bool (*binary_op)(int, int, int&)>
+inline LispValue _packed(std::vector<LispValue>& evaluated_arguments, const char* name);
+inline LispPackedNumbers _spread(const std::vector<LispValue>& evaluated_arguments, const char* name);
+template <typename XIterator, typename YIterator>
+inline LispBigInteger _dot(XIterator x_itr, XIterator x_end, YIterator y_itr);
 inline LispValue _ifdo(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment,
     const std::string& name,
     const bool when_or_unless
 );
-
-inline int _add(int x, int y);
-inline int _sub(int x, int y);
-inline int _mul(int x, int y);
-inline int _div(int x, int y);
-inline int _mod(int x, int y);
-inline int _pow(int x, int y);
-inline int _posi(int x);
+inline LispValue _stats(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::vector<std::pair<std::string, size_t>>& counters,
+    const std::string& name
+);
+inline LispValue _counters(const std::vector<std::pair<std::string, size_t>>& counters);
+inline LispValue _apply(
+    LispValue& function,
+    std::vector<LispValue>& arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+);
+inline std::vector<LispValue> _elements(const LispValue& list, const std::string& name);
+template <typename Task>
+inline void _run_chunks(size_t length, const Task& task);
+
+inline bool _mul(int x, int y, int& result);
+inline bool _div(int x, int y, int& result);
+inline bool _mod(int x, int y, int& result);
+inline bool _pow(int x, int y, int& result);
 inline int _nega(int x);
 
-inline int _and(int x, int y);
-inline int _or(int x, int y);
+inline bool _and(int x, int y, int& result);
+inline bool _or(int x, int y, int& result);
 inline int _not(int x);
-inline int _gt(int x, int y);
-inline int _geq(int x, int y);
-inline int _lt(int x, int y);
-inline int _leq(int x, int y);
 
-inline bool all_type_of(const std::vector<LispValue>& cells, LispType type);
+inline LispBigInteger _big_add(const LispBigInteger& x, const LispBigInteger& y);
+inline LispBigInteger _big_sub(const LispBigInteger& x, const LispBigInteger& y);
+inline LispBigInteger _big_mul(const LispBigInteger& x, const LispBigInteger& y);
+inline LispBigInteger _big_div(const LispBigInteger& x, const LispBigInteger& y);
+inline LispBigInteger _big_mod(const LispBigInteger& x, const LispBigInteger& y);
+inline LispBigInteger _big_pow(const LispBigInteger& x, const LispBigInteger& y);
+inline LispBigInteger _big_and(const LispBigInteger& x, const LispBigInteger& y);
+inline LispBigInteger _big_or(const LispBigInteger& x, const LispBigInteger& y);
+
+inline double _real_add(double x, double y);
+inline double _real_sub(double x, double y);
+inline double _real_mul(double x, double y);
+inline double _real_div(double x, double y);
+inline double _real_mod(double x, double y);
+inline double _real_pow(double x, double y);
+
+inline int _number_of(const LispValue& value);
+inline int _number_of(int number);
+inline LispBigInteger _big_integer_of(const LispValue& value);
+inline LispBigInteger _big_integer_of(double value);
+inline double _real_of(const LispValue& value);
+inline bool _is_nan(const LispValue& value);
+inline int _compare_numbers(const LispValue& x, const LispValue& y);
+inline bool _is_in_order(int comparison, LispOrder order);
+
+template<typename Cells>
+inline bool all_type_of(const Cells& cells, LispType type);
+template<typename Cells>
+inline bool all_numbers(const Cells& cells);
+template<typename Cells>
+inline bool all_reals(const Cells& cells);
+template<typename Cells>
+inline bool any_type_of(const Cells& cells, LispType type);
 
 
 LispValue builtin_add(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _operator(evaluated_arguments, _posi, _add, "add");
+    return _sum(evaluated_arguments, false, "add");
 }
 
 LispValue builtin_sub(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _operator(evaluated_arguments, _nega, _sub, "sub");
+    return _sum(evaluated_arguments, true, "sub");
 }
 
 LispValue builtin_mul(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _operator(evaluated_arguments, _mul, "mul");
+    return _operator<_mul, _big_mul, _real_mul>(evaluated_arguments, "mul");
 }
 
 LispValue builtin_div(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _operator(evaluated_arguments, _div, "div");
+    return _operator<_div, _big_div, _real_div>(evaluated_arguments, "div");
 }
 
 LispValue builtin_mod(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _operator(evaluated_arguments, _mod, "mod");
+    return _operator<_mod, _big_mod, _real_mod>(evaluated_arguments, "mod");
 }
 
 LispValue builtin_pow(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _operator(evaluated_arguments, _pow, "pow");
+    return _operator<_pow, _big_pow, _real_pow>(evaluated_arguments, "pow");
+}
+
+LispValue builtin_sum(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 1) {
+        throw std::invalid_argument("Error: function sum takes one argument");
+    }
+    const LispValue& argument(evaluated_arguments[0]);
+    if (argument.type == LispType::Vector) {
+        const LispVectorView numbers(argument.numbers());
+        return LispValue(LispType::Number, LispBigInteger(sum_packed(numbers.begin(), numbers.end())));
+    }
+    if (argument.type != LispType::Q_Expression || !all_reals(argument.cells())) {
+        throw std::invalid_argument("Error: function sum takes vector or Q-Expression of numbers");
+    }
+
+    if (any_type_of(argument.cells(), LispType::Float)) {
+        double total = 0;
+        for (const LispValue& cell : argument.cells()) total += _real_of(cell);
+        return LispValue(LispType::Float, total);
+    }
+    if (!all_type_of(argument.cells(), LispType::Number)) {
+        LispBigInteger total;
+        for (const LispValue& cell : argument.cells()) total = total + _big_integer_of(cell);
+        return LispValue(LispType::Number, std::move(total));
+    }
+    /* partial sums of ints are 64 bits wide, and cannot overflow */
+    long long total = 0;
+    for (const LispValue& cell : argument.cells()) total += cell.number;
+    return LispValue(LispType::Number, LispBigInteger(total));
+}
+
+LispValue builtin_dot(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 2) {
+        throw std::invalid_argument("Error: function dot takes two arguments");
+    }
+    const LispValue& x(evaluated_arguments[0]);
+    const LispValue& y(evaluated_arguments[1]);
+    if (x.type == LispType::Vector && y.type == LispType::Vector) {
+        if (x.numbers().size() != y.numbers().size()) {
+            throw std::invalid_argument("Error: function dot takes vectors of the same length");
+        }
+        return LispValue(LispType::Number, _dot(x.numbers().begin(), x.numbers().end(), y.numbers().begin()));
+    }
+    if (
+        x.type != LispType::Q_Expression || !all_type_of(x.cells(), LispType::Number) ||
+        y.type != LispType::Q_Expression || !all_type_of(y.cells(), LispType::Number)
+    ) {
+        throw std::invalid_argument("Error: function dot takes two vectors or Q-Expressions of numbers");
+    }
+    if (x.cells().size() != y.cells().size()) {
+        throw std::invalid_argument("Error: function dot takes Q-Expressions of the same length");
+    }
+    return LispValue(LispType::Number, _dot(x.cells().begin(), x.cells().end(), y.cells().begin()));
 }
 
 LispValue builtin_if(
@@ -121,10 +230,10 @@ LispValue builtin_if(
 
     if (condition.number) {
         then_qexpr.type = LispType::S_Expression;
-        return evaluate(then_qexpr, environment);
+        return evaluate_tail(then_qexpr, environment);
     } else {
         else_qexpr.type = LispType::S_Expression;
-        return evaluate(else_qexpr, environment);
+        return evaluate_tail(else_qexpr, environment);
     }
 }
 
@@ -135,22 +244,24 @@ LispValue builtin_cond(
     for (const LispValue& argument : evaluated_arguments) {
         if (
             argument.type != LispType::Q_Expression ||
-            argument.cells.size() != 2 || 
-            argument.cells[1].type != LispType::Q_Expression
+            argument.cells().size() != 2 ||
+            argument.cells()[1].type != LispType::Q_Expression
         ) {
             throw std::invalid_argument(
                 "Error: each argument is expected to be { condition { statement } }");
         }
     }
-    const LispValue& otherwise(environment->resolve("otherwise"));
-    for (LispValue& argument : evaluated_arguments) {
-        LispValue condition = evaluate(argument.cells[0], environment);
+    static const LispValue otherwise(LispType::Symbol, "otherwise");
+    for (const LispValue& argument : evaluated_arguments) {
+        LispValue condition(argument.cells()[0]);
+        condition = evaluate(condition, environment);
         if (condition.type != LispType::Number && condition != otherwise) {
             throw std::invalid_argument("Error: condition does not evaluate to number");
         }
         if ((condition.type == LispType::Number && condition.number) || condition == otherwise) {
-            argument.cells[1].type = LispType::S_Expression;
-            return evaluate(argument.cells[1], environment);
+            LispValue statement(argument.cells()[1]);
+            statement.type = LispType::S_Expression;
+            return evaluate_tail(statement, environment);
         }
     }
     return LispValue();
@@ -168,21 +279,21 @@ LispValue builtin_case(
     for (const LispValue& condition_statement : evaluated_arguments) {
         if (
             condition_statement.type != LispType::Q_Expression ||
-            condition_statement.cells.size() != 2 ||
-            condition_statement.cells[1].type != LispType::Q_Expression
+            condition_statement.cells().size() != 2 ||
+            condition_statement.cells()[1].type != LispType::Q_Expression
         ) {
             throw std::invalid_argument(
                 "Error: each condition statement is expected to be { value { statement } }");
         }
     }
 
-    const LispValue& otherwise(environment->resolve("otherwise"));
-    for (LispValue& condition_statement : evaluated_arguments) {
-        const LispValue& case_value(condition_statement.cells[0]);
-        LispValue& statement(condition_statement.cells[1]);
+    static const LispValue otherwise(LispType::Symbol, "otherwise");
+    for (const LispValue& condition_statement : evaluated_arguments) {
+        const LispValue& case_value(condition_statement.cells()[0]);
+        LispValue statement(condition_statement.cells()[1]);
         if (value == case_value || case_value == otherwise) {
             statement.type = LispType::S_Expression;
-            return evaluate(statement, environment);
+            return evaluate_tail(statement, environment);
         }
     }
     return LispValue();
@@ -206,21 +317,21 @@ LispValue builtin_and(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _operator(evaluated_arguments, _and, "and");
+    return _operator<_and, _big_and, nullptr>(evaluated_arguments, "and");
 }
 
 LispValue builtin_or(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _operator(evaluated_arguments, _or, "or");
+    return _operator<_or, _big_or, nullptr>(evaluated_arguments, "or");
 }
 
 LispValue builtin_not(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _operator(evaluated_arguments, _not, "not");
+    return _operator<_not>(evaluated_arguments, "not");
 }
 
 LispValue builtin_eq(
@@ -247,28 +358,28 @@ LispValue builtin_gt(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _relation(evaluated_arguments, _gt, "gt");
+    return _relation(evaluated_arguments, LispOrder::Greater, "gt");
 }
 
 LispValue builtin_geq(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _relation(evaluated_arguments, _geq, "geq");
+    return _relation(evaluated_arguments, LispOrder::GreaterEqual, "geq");
 }
 
 LispValue builtin_lt(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _relation(evaluated_arguments, _lt, "lt");
+    return _relation(evaluated_arguments, LispOrder::Less, "lt");
 }
 
 LispValue builtin_leq(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return _relation(evaluated_arguments, _leq, "leq");
+    return _relation(evaluated_arguments, LispOrder::LessEqual, "leq");
 }
 
 LispValue builtin_list(
@@ -286,12 +397,11 @@ LispValue builtin_cons(
         throw std::invalid_argument("Error: function cons takes two arguments");
     }
     const LispValue& head(evaluated_arguments[0]);
-    LispValue& tail(evaluated_arguments[1]);
+    const LispValue& tail(evaluated_arguments[1]);
     if (tail.type != LispType::Q_Expression) {
         throw std::invalid_argument("Error: second argument is expected to be Q-Expression");
     }
-    tail.cells.insert(tail.cells.begin(), head);
-    return tail;
+    return LispValue(LispType::Q_Expression, head, tail);
 }
 
 LispValue builtin_eval(
@@ -307,7 +417,7 @@ LispValue builtin_eval(
     }
 
     argument.type = LispType::S_Expression;
-    return evaluate(argument, environment);
+    return evaluate_tail(argument, environment);
 }
 
 LispValue builtin_head(
@@ -319,17 +429,22 @@ LispValue builtin_head(
     }
     LispValue& argument(evaluated_arguments[0]);
     if (argument.type == LispType::String) {
-        if (argument.str.empty()) {
+        if (argument.str().empty()) {
             throw std::invalid_argument("Error: argument is empty string");
         }
-        argument.str = argument.str[0];
+        argument = argument.substr(0, 1);
     } else if (argument.type == LispType::Q_Expression) {
-        if (argument.cells.empty()) {
+        if (argument.cells().empty()) {
             throw std::invalid_argument("Error: argument is empty Q-Expression");
         }
-        argument.cells = { argument.cells[0] };
+        argument = LispValue(LispType::Q_Expression, argument.cells().front(), LispValue());
+    } else if (argument.type == LispType::Vector) {
+        if (argument.numbers().empty()) {
+            throw std::invalid_argument("Error: argument is empty vector");
+        }
+        argument = argument.slice(0, 1);
     } else {
-        throw std::invalid_argument("Error: function head takes string or Q-Expression");
+        throw std::invalid_argument("Error: function head takes string, vector or Q-Expression");
     }
     return argument;
 }
@@ -343,18 +458,24 @@ LispValue builtin_tail(
     }
     LispValue& argument(evaluated_arguments[0]);
     if (argument.type == LispType::String) {
-        const size_t len = argument.str.length();
+        const size_t len = argument.str().length();
         if (len == 0) {
             throw std::invalid_argument("Error: argument is empty string");
         }
-        argument.str = argument.str.substr(1, len - 1);
+        argument = argument.substr(1, len - 1);
     } else if (argument.type == LispType::Q_Expression) {
-        if (argument.cells.empty()) {
+        if (argument.cells().empty()) {
             throw std::invalid_argument("Error: the argument is empty Q-Expression");
         }
-        argument.cells.erase(argument.cells.begin());
+        argument = argument.drop(1);
+    } else if (argument.type == LispType::Vector) {
+        const size_t len = argument.numbers().size();
+        if (len == 0) {
+            throw std::invalid_argument("Error: argument is empty vector");
+        }
+        argument = argument.slice(1, len - 1);
     } else {
-        throw std::invalid_argument("Error: function tail takes string or Q-Expression");
+        throw std::invalid_argument("Error: function tail takes string, vector or Q-Expression");
     }
     return argument;
 }
@@ -371,19 +492,34 @@ LispValue builtin_join(
     const cells_itr begin = evaluated_arguments.begin() + 1, end = evaluated_arguments.end();
 
     if (all_type_of(evaluated_arguments, LispType::Q_Expression)) {
-        LispValue& result(evaluated_arguments[0]);
-        for (cells_itr itr = begin; itr != end; itr++) {
-            result.cells.insert(result.cells.end(), itr->cells.begin(), itr->cells.end());
+        /* copy the cells of every list but the last one, which is shared */
+        std::vector<const LispValue*> cells;
+        for (cells_itr itr = begin - 1; itr != end - 1; itr++) {
+            for (const LispValue& cell : itr->cells()) cells.push_back(&cell);
+        }
+        LispValue result(evaluated_arguments.back());
+        for (size_t index = cells.size(); index > 0; index--) {
+            result = LispValue(LispType::Q_Expression, *cells[index - 1], result);
         }
         return result;
     } else if (all_type_of(evaluated_arguments, LispType::String)) {
-        LispValue& result(evaluated_arguments[0]);
+        std::string result(evaluated_arguments[0].str().to_string());
         for (cells_itr itr = begin; itr != end; itr++) {
-            result.str += itr->str;
+            result.append(itr->str().data(), itr->str().size());
         }
-        return result;
+        return LispValue(LispType::String, result);
+    } else if (all_type_of(evaluated_arguments, LispType::Vector)) {
+        if (evaluated_arguments.size() == 1) return evaluated_arguments[0];
+        size_t length = 0;
+        for (const LispValue& argument : evaluated_arguments) length += argument.numbers().size();
+        LispPackedNumbers result;
+        result.reserve(length);
+        for (const LispValue& argument : evaluated_arguments) {
+            result.insert(result.end(), argument.numbers().begin(), argument.numbers().end());
+        }
+        return LispValue(LispType::Vector, std::move(result));
     } else {
-        throw std::invalid_argument("Error: function join takes strings or Q-Expressions");
+        throw std::invalid_argument("Error: function join takes strings, vectors or Q-Expressions");
     }
 }
 
@@ -396,14 +532,332 @@ LispValue builtin_len(
     }
     const LispValue& argument(evaluated_arguments[0]);
     if (argument.type == LispType::Q_Expression) {
-        return LispValue(LispType::Number, argument.cells.size());
+        return LispValue(LispType::Number, static_cast<int>(argument.cells().size()));
+    } else if (argument.type == LispType::String) {
+        return LispValue(LispType::Number, static_cast<int>(argument.str().length()));
+    } else if (argument.type == LispType::Vector) {
+        return LispValue(LispType::Number, static_cast<int>(argument.numbers().size()));
+    } else {
+        throw std::invalid_argument("Error: function len takes string, vector or Q-Expression");
+    }
+}
+
+LispValue builtin_map(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() < 2) {
+        throw std::invalid_argument("Error: function map takes two or more arguments");
+    }
+    LispValue function(evaluated_arguments[0]);
+    if (function.type != LispType::BuiltinFunction && function.type != LispType::LambdaFunction) {
+        throw std::invalid_argument("Error: first argument is expected to be function");
+    }
+    const std::vector<LispValue> lists(evaluated_arguments.begin() + 1, evaluated_arguments.end());
+    const bool is_packed = all_type_of(lists, LispType::Vector);
+    if (!is_packed && !all_type_of(lists, LispType::Q_Expression)) {
+        throw std::invalid_argument("Error: function map takes vectors or Q-Expressions after the function");
+    }
+    const size_t length = is_packed ? lists.front().numbers().size() : lists.front().cells().size();
+    for (const LispValue& list : lists) {
+        if ((is_packed ? list.numbers().size() : list.cells().size()) != length) {
+            throw std::invalid_argument("Error: function map takes lists of the same length");
+        }
+    }
+
+    /* the function is called on the elements at each position, taken across the lists */
+    std::vector<LispCells::iterator> positions;
+    if (!is_packed) {
+        for (const LispValue& list : lists) positions.push_back(list.cells().begin());
+    }
+    std::vector<LispValue> results;
+    LispPackedNumbers packed_results;
+    if (is_packed) packed_results.reserve(length);
+    else           results.reserve(length);
+    for (size_t index = 0; index < length; index++) {
+        std::vector<LispValue> arguments;
+        arguments.reserve(lists.size());
+        if (is_packed) {
+            for (const LispValue& list : lists) {
+                arguments.push_back(LispValue(LispType::Number, list.numbers()[index]));
+            }
+        } else {
+            for (LispCells::iterator& position : positions) {
+                arguments.push_back(*position);
+                ++position;
+            }
+        }
+
+        LispValue result = _apply(function, arguments, environment);
+        if (!is_packed) {
+            results.push_back(std::move(result));
+        } else if (result.type == LispType::Number) {
+            packed_results.push_back(result.number);
+        } else {
+            throw std::invalid_argument("Error: function mapped over vectors is expected to return numbers");
+        }
+    }
+    if (is_packed) return LispValue(LispType::Vector, std::move(packed_results));
+    return LispValue(LispType::Q_Expression, results);
+}
+
+LispValue builtin_pmap(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 2) {
+        throw std::invalid_argument("Error: function pmap takes two arguments");
+    }
+    const LispValue& function(evaluated_arguments[0]);
+    if (function.type != LispType::BuiltinFunction && function.type != LispType::LambdaFunction) {
+        throw std::invalid_argument("Error: first argument is expected to be function");
+    }
+    const bool is_packed = evaluated_arguments[1].type == LispType::Vector;
+    std::vector<LispValue> results(_elements(evaluated_arguments[1], "pmap"));
+
+    /* every element is replaced by its result in place */
+    _run_chunks(results.size(), [&](size_t begin, size_t end) {
+        LispValue chunk_function(function);
+        for (size_t index = begin; index < end; index++) {
+            std::vector<LispValue> arguments(1, std::move(results[index]));
+            results[index] = _apply(chunk_function, arguments, environment);
+            if (is_packed && results[index].type != LispType::Number) {
+                throw std::invalid_argument("Error: function mapped over vectors is expected to return numbers");
+            }
+        }
+    });
+
+    if (!is_packed) return LispValue(LispType::Q_Expression, results);
+    LispPackedNumbers packed_results;
+    packed_results.reserve(results.size());
+    for (const LispValue& result : results) packed_results.push_back(result.number);
+    return LispValue(LispType::Vector, std::move(packed_results));
+}
+
+LispValue builtin_pfilter(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 2) {
+        throw std::invalid_argument("Error: function pfilter takes two arguments");
+    }
+    const LispValue& function(evaluated_arguments[0]);
+    if (function.type != LispType::BuiltinFunction && function.type != LispType::LambdaFunction) {
+        throw std::invalid_argument("Error: first argument is expected to be function");
+    }
+    const std::vector<LispValue> elements(_elements(evaluated_arguments[1], "pfilter"));
+    std::vector<char> is_kept(elements.size());
+
+    _run_chunks(elements.size(), [&](size_t begin, size_t end) {
+        LispValue chunk_function(function);
+        for (size_t index = begin; index < end; index++) {
+            std::vector<LispValue> arguments(1, elements[index]);
+            const LispValue result = _apply(chunk_function, arguments, environment);
+            if (result.type != LispType::Number) {
+                throw std::invalid_argument("Error: function pfilter takes a predicate returning numbers");
+            }
+            is_kept[index] = result.number != 0;
+        }
+    });
+
+    if (evaluated_arguments[1].type == LispType::Vector) {
+        LispPackedNumbers kept;
+        for (size_t index = 0; index < elements.size(); index++) {
+            if (is_kept[index]) kept.push_back(elements[index].number);
+        }
+        return LispValue(LispType::Vector, std::move(kept));
+    }
+    std::vector<LispValue> kept;
+    for (size_t index = 0; index < elements.size(); index++) {
+        if (is_kept[index]) kept.push_back(elements[index]);
+    }
+    return LispValue(LispType::Q_Expression, kept);
+}
+
+LispValue builtin_preduce(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 2 && evaluated_arguments.size() != 3) {
+        throw std::invalid_argument("Error: function preduce takes two or three arguments");
+    }
+    LispValue function(evaluated_arguments[0]);
+    if (function.type != LispType::BuiltinFunction && function.type != LispType::LambdaFunction) {
+        throw std::invalid_argument("Error: first argument is expected to be function");
+    }
+    const bool has_initial = evaluated_arguments.size() == 3;
+    const std::vector<LispValue> elements(_elements(evaluated_arguments.back(), "preduce"));
+    if (elements.empty()) {
+        if (has_initial) return evaluated_arguments[1];
+        throw std::invalid_argument("Error: function preduce takes an initial value for an empty list");
+    }
+
+    /* chunks are folded apart, which is why the function has to be associative, then in order */
+    std::vector<LispValue> partials(elements.size());
+    std::vector<char> is_folded(elements.size());
+    _run_chunks(elements.size(), [&](size_t begin, size_t end) {
+        LispValue chunk_function(function);
+        LispValue partial(elements[begin]);
+        for (size_t index = begin + 1; index < end; index++) {
+            std::vector<LispValue> arguments{ std::move(partial), elements[index] };
+            partial = _apply(chunk_function, arguments, environment);
+        }
+        partials[begin] = std::move(partial);
+        is_folded[begin] = true;
+    });
+
+    LispValue result(has_initial ? evaluated_arguments[1] : LispValue());
+    bool has_result = has_initial;
+    for (size_t index = 0; index < partials.size(); index++) {
+        if (!is_folded[index]) continue;
+        if (!has_result) {
+            result = std::move(partials[index]);
+            has_result = true;
+            continue;
+        }
+        std::vector<LispValue> arguments{ std::move(result), std::move(partials[index]) };
+        result = _apply(function, arguments, environment);
+    }
+    return result;
+}
+
+LispValue builtin_nth(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 2) {
+        throw std::invalid_argument("Error: function nth takes two arguments");
+    }
+    const LispValue& argument(evaluated_arguments[0]);
+    const LispValue& index(evaluated_arguments[1]);
+    if (index.type != LispType::Number) {
+        throw std::invalid_argument("Error: second argument is expected to be number");
+    }
+
+    if (argument.type == LispType::Vector) {
+        if (index.number < 0 || static_cast<size_t>(index.number) >= argument.numbers().size()) {
+            throw std::out_of_range("Error: index is out of range");
+        }
+        return LispValue(LispType::Number, argument.numbers()[index.number]);
+    } else if (argument.type == LispType::Q_Expression) {
+        if (index.number < 0 || static_cast<size_t>(index.number) >= argument.cells().size()) {
+            throw std::out_of_range("Error: index is out of range");
+        }
+        return argument.cells()[index.number];
     } else if (argument.type == LispType::String) {
-        return LispValue(LispType::Number, argument.str.length());
+        if (index.number < 0 || static_cast<size_t>(index.number) >= argument.str().length()) {
+            throw std::out_of_range("Error: index is out of range");
+        }
+        return argument.substr(index.number, 1);
     } else {
-        throw std::invalid_argument("Error: function len takes string or Q-Expression");
+        throw std::invalid_argument("Error: function nth takes string, vector or Q-Expression");
     }
 }
 
+LispValue builtin_slice(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 3) {
+        throw std::invalid_argument("Error: function slice takes three arguments");
+    }
+    const LispValue& argument(evaluated_arguments[0]);
+    const LispValue& start(evaluated_arguments[1]);
+    const LispValue& end(evaluated_arguments[2]);
+    if (start.type != LispType::Number || end.type != LispType::Number) {
+        throw std::invalid_argument("Error: second and third argument is expected to be number");
+    }
+
+    size_t length;
+    if (argument.type == LispType::Vector)            length = argument.numbers().size();
+    else if (argument.type == LispType::Q_Expression) length = argument.cells().size();
+    else if (argument.type == LispType::String)       length = argument.str().length();
+    else throw std::invalid_argument("Error: function slice takes string, vector or Q-Expression");
+    if (start.number < 0 || end.number < start.number || static_cast<size_t>(end.number) > length) {
+        throw std::out_of_range("Error: slice is out of range");
+    }
+
+    /* vectors and strings share their storage, lists the cells up to their end */
+    const size_t count = end.number - start.number;
+    if (argument.type == LispType::Vector) return argument.slice(start.number, count);
+    if (argument.type == LispType::String) return argument.substr(start.number, count);
+    const LispValue rest(argument.drop(start.number));
+    if (static_cast<size_t>(end.number) == length) return rest;
+    std::vector<LispValue> cells;
+    cells.reserve(count);
+    for (LispCells::iterator itr = rest.cells().begin(); cells.size() < count; ++itr) cells.push_back(*itr);
+    return LispValue(LispType::Q_Expression, cells);
+}
+
+LispValue builtin_vector(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (!all_type_of(evaluated_arguments, LispType::Number)) {
+        throw std::invalid_argument("Error: function vector takes numbers");
+    }
+    LispPackedNumbers numbers;
+    numbers.reserve(evaluated_arguments.size());
+    for (const LispValue& argument : evaluated_arguments) numbers.push_back(argument.number);
+    return LispValue(LispType::Vector, std::move(numbers));
+}
+
+LispValue builtin_range(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 2 || !all_type_of(evaluated_arguments, LispType::Number)) {
+        throw std::invalid_argument("Error: function range takes two numbers");
+    }
+    const int start = evaluated_arguments[0].number, end = evaluated_arguments[1].number;
+    /* the span is taken in 64 bits, where the difference of two ints always fits */
+    const long long length = start < end ? static_cast<long long>(end) - start : 0;
+    if (length > max_range_length) {
+        throw std::invalid_argument(
+            "Error: function range makes at most " + std::to_string(max_range_length) + " numbers");
+    }
+    LispPackedNumbers numbers(static_cast<size_t>(length));
+    for (size_t index = 0; index < numbers.size(); index++) numbers[index] = start + static_cast<int>(index);
+    return LispValue(LispType::Vector, std::move(numbers));
+}
+
+LispValue builtin_to_vector(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 1) {
+        throw std::invalid_argument("Error: function to-vector takes one argument");
+    }
+    const LispValue& argument(evaluated_arguments[0]);
+    if (argument.type != LispType::Q_Expression || !all_type_of(argument.cells(), LispType::Number)) {
+        throw std::invalid_argument("Error: function to-vector takes Q-Expression of numbers");
+    }
+    LispPackedNumbers numbers;
+    numbers.reserve(argument.cells().size());
+    for (const LispValue& cell : argument.cells()) numbers.push_back(cell.number);
+    return LispValue(LispType::Vector, std::move(numbers));
+}
+
+LispValue builtin_to_list(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 1) {
+        throw std::invalid_argument("Error: function to-list takes one argument");
+    }
+    const LispValue& argument(evaluated_arguments[0]);
+    if (argument.type != LispType::Vector) {
+        throw std::invalid_argument("Error: function to-list takes vector");
+    }
+    /* cells are made from the back, so that each one is shared by the next as its tail */
+    LispValue result(LispType::Q_Expression);
+    const LispVectorView numbers(argument.numbers());
+    for (const int* itr = numbers.end(); itr != numbers.begin();) {
+        result = LispValue(LispType::Q_Expression, LispValue(LispType::Number, *--itr), result);
+    }
+    return result;
+}
+
 LispValue builtin_lambda(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
@@ -411,18 +865,18 @@ LispValue builtin_lambda(
     if (evaluated_arguments.size() != 2) {
         throw std::invalid_argument("Error: function lambda takes two arguments");
     }
-    std::vector<LispValue>& params(evaluated_arguments[0].cells);
     if (
         evaluated_arguments[0].type != LispType::Q_Expression ||
-        !all_type_of(params, LispType::Symbol)
+        !all_type_of(evaluated_arguments[0].cells(), LispType::Symbol)
     ) {
         throw std::invalid_argument(
             "Error: first argument is expected to be Q-Expression of zero or more symbols");
     }
 
+    const LispCells params(evaluated_arguments[0].cells());
     const bool reserved_symbol_exists = std::any_of(
         params.begin(), params.end(),
-        [&environment](const LispValue& value) { return environment->is_reserved(value.symbol); }
+        [&environment](const LispValue& value) { return environment->is_reserved(value.symbol_id()); }
     );
     if (reserved_symbol_exists) {
         throw std::invalid_argument("Error: cannot use reserved symbol as parameter name");
@@ -431,8 +885,7 @@ LispValue builtin_lambda(
         throw std::invalid_argument("Error: second argument is expected to be Q-Expression");
     }
 
-    std::shared_ptr<LispEnvironment> local_env(new LispEnvironment(environment));
-    return LispValue(LispType::LambdaFunction, evaluated_arguments, local_env);
+    return make_lambda_function(evaluated_arguments[0], evaluated_arguments[1], environment);
 }
 
 LispValue builtin_def(
@@ -443,18 +896,19 @@ LispValue builtin_def(
         throw std::invalid_argument("Error: function def takes 2 or more arguments");
     }
 
-    const std::vector<LispValue>& symbols(evaluated_arguments[0].cells);
     if (
         evaluated_arguments[0].type != LispType::Q_Expression ||
-        symbols.size() < 1 || !all_type_of(symbols, LispType::Symbol)
+        evaluated_arguments[0].cells().size() < 1 ||
+        !all_type_of(evaluated_arguments[0].cells(), LispType::Symbol)
     ) {
         throw std::invalid_argument(
             "Error: first argument is expected to be Q-Expression of one or more symbols");
     }
 
+    const LispCells symbols(evaluated_arguments[0].cells());
     const bool reserved_symbol_exists = std::any_of(
         symbols.begin(), symbols.end(),
-        [&environment](const LispValue& value) { return environment->is_reserved(value.symbol); }
+        [&environment](const LispValue& value) { return environment->is_reserved(value.symbol_id()); }
     );
     if (reserved_symbol_exists) {
         throw std::invalid_argument("Error: cannot re-define reserved symbol");
@@ -464,7 +918,8 @@ LispValue builtin_def(
     }
 
     for (size_t index = 0, size = symbols.size(); index < size; index++) {
-        environment->define_global(symbols[index].symbol, evaluated_arguments[index + 1]);
+        environment->define_global(symbols[index].symbol_id(), evaluated_arguments[index + 1]);
+        LispProfiler::name(evaluated_arguments[index + 1], symbols[index].symbol_id());
     }
     return LispValue();
 }
@@ -476,21 +931,22 @@ LispValue builtin_defun(
     if (evaluated_arguments.size() != 2) {
         throw std::invalid_argument("Error: function defun takes two arguments");
     }
-    std::vector<LispValue>& signiture(evaluated_arguments[0].cells);
     if (
         evaluated_arguments[0].type != LispType::Q_Expression ||
-        signiture.size() < 1 || !all_type_of(signiture, LispType::Symbol)
+        evaluated_arguments[0].cells().size() < 1 ||
+        !all_type_of(evaluated_arguments[0].cells(), LispType::Symbol)
     ) {
         throw std::invalid_argument(
             "Error: first argument is expected to be Q-Expression of one or more symbols");
     }
-    if (environment->is_reserved(signiture[0].symbol)) {
+    const LispCells signiture(evaluated_arguments[0].cells());
+    if (environment->is_reserved(signiture.front().symbol_id())) {
         throw std::invalid_argument("Error: cannot re-define reserved symbol");
     }
 
     const bool reserved_symbol_exists = std::any_of(
-        signiture.begin() + 1, signiture.end(),
-        [&environment](const LispValue& value) { return environment->is_reserved(value.symbol); }
+        ++signiture.begin(), signiture.end(),
+        [&environment](const LispValue& value) { return environment->is_reserved(value.symbol_id()); }
     );
     if (reserved_symbol_exists) {
         throw std::invalid_argument("Error: cannot use reserved symbol as parameter name");
@@ -499,17 +955,37 @@ LispValue builtin_defun(
         throw std::invalid_argument("Error: second argument is expected to be Q-Expression");
     }
 
-    LispValue symbol(signiture[0]);
-    signiture.erase(signiture.begin());
+    const LispValue& symbol(signiture.front());
+    const LispValue function(
+        make_lambda_function(evaluated_arguments[0].drop(1), evaluated_arguments[1], environment));
 
-    std::shared_ptr<LispEnvironment> local_env(new LispEnvironment(environment));
-    environment->define_global(
-        symbol.symbol,
-        LispValue(LispType::LambdaFunction, evaluated_arguments, local_env)
-    );
+    environment->define_global(symbol.symbol_id(), function);
+    LispProfiler::name(function, symbol.symbol_id());
     return LispValue();
 }
 
+LispValue builtin_memoize(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 1 && evaluated_arguments.size() != 2) {
+        throw std::invalid_argument("Error: function memoize takes one or two arguments");
+    }
+    const LispValue& function(evaluated_arguments[0]);
+    if (function.type != LispType::LambdaFunction) {
+        throw std::invalid_argument("Error: first argument is expected to be lambda function");
+    }
+    size_t capacity = default_memo_capacity;
+    if (evaluated_arguments.size() == 2) {
+        const LispValue& argument(evaluated_arguments[1]);
+        if (argument.type != LispType::Number || argument.number <= 0) {
+            throw std::invalid_argument("Error: second argument is expected to be positive number");
+        }
+        capacity = argument.number;
+    }
+    return LispValue(LispType::LambdaFunction, function, std::make_shared<LispMemoTable>(capacity));
+}
+
 LispValue builtin_del(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
@@ -517,17 +993,18 @@ LispValue builtin_del(
     if (evaluated_arguments.size() != 1) {
         throw std::invalid_argument("Error: function del takes one argument");
     }
-    const std::vector<LispValue>& symbols(evaluated_arguments[0].cells);
     if (
         evaluated_arguments[0].type != LispType::Q_Expression ||
-        symbols.size() < 1 || !all_type_of(symbols, LispType::Symbol)
+        evaluated_arguments[0].cells().size() < 1 ||
+        !all_type_of(evaluated_arguments[0].cells(), LispType::Symbol)
     ) {
         throw std::invalid_argument(
             "Error: first argument is expected to be Q-Expression of one or more symbols");
     }
 
+    const LispCells symbols(evaluated_arguments[0].cells());
     for (const LispValue& symbol : symbols) {
-        environment->delete_global(symbol.symbol);
+        environment->delete_global(symbol.symbol_id());
     }
     return LispValue();
 }
@@ -540,22 +1017,28 @@ LispValue builtin_do(
         throw std::invalid_argument("Error: function do takes Q-Expressions");
     }
 
-    LispValue result;
-    for (LispValue& argument : evaluated_arguments) {
-        argument.type = LispType::S_Expression;
-        result = evaluate(argument, environment);
+    if (evaluated_arguments.empty()) return LispValue();
+    for (size_t index = 0, last = evaluated_arguments.size() - 1; index < last; index++) {
+        evaluated_arguments[index].type = LispType::S_Expression;
+        evaluate(evaluated_arguments[index], environment);
     }
-    return result;
+    evaluated_arguments.back().type = LispType::S_Expression;
+    return evaluate_tail(evaluated_arguments.back(), environment);
 }
 
 LispValue builtin_print(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
+    /* lines printed by parallel tasks are kept whole */
+    static std::mutex output_mutex;
+    std::unique_lock<std::mutex> lock(output_mutex, std::defer_lock);
+    if (LispThreadPool::is_parallel()) lock.lock();
+    std::ostream& output(environment->output());
     for (size_t index = 0, size = evaluated_arguments.size(); index < size; index++) {
-        std::cout << evaluated_arguments[index];
-        if (index != size - 1) std::cout << ' ';
-        else                   std::cout << std::endl;
+        output << evaluated_arguments[index];
+        if (index != size - 1) output << ' ';
+        else                   output << std::endl;
     }
     return LispValue();
 }
@@ -570,6 +1053,48 @@ LispValue builtin_type(
     return LispValue(LispType::String, evaluated_arguments[0].type_name());
 }
 
+LispValue builtin_load(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 1) {
+        throw std::invalid_argument("Error: function load takes one argument");
+    }
+    if (evaluated_arguments[0].type != LispType::String) {
+        throw std::invalid_argument("Error: function load takes string");
+    }
+    load_script(evaluated_arguments[0].str().to_string(), environment);
+    return LispValue();
+}
+
+LispValue builtin_save_image(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 1) {
+        throw std::invalid_argument("Error: function save-image takes one argument");
+    }
+    if (evaluated_arguments[0].type != LispType::String) {
+        throw std::invalid_argument("Error: function save-image takes string");
+    }
+    save_image(evaluated_arguments[0].str().to_string(), environment);
+    return LispValue();
+}
+
+LispValue builtin_load_image(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (evaluated_arguments.size() != 1) {
+        throw std::invalid_argument("Error: function load-image takes one argument");
+    }
+    if (evaluated_arguments[0].type != LispType::String) {
+        throw std::invalid_argument("Error: function load-image takes string");
+    }
+    load_image(evaluated_arguments[0].str().to_string(), environment);
+    return LispValue();
+}
+
 LispValue builtin_exit(
     std::vector<LispValue>& evaluated_arguments,
     const std::shared_ptr<LispEnvironment>& environment
@@ -578,78 +1103,211 @@ LispValue builtin_exit(
     if (num_args != 1) {
         throw std::invalid_argument("Error: function exit takes zero or one argument");
     }
+    if (LispThreadPool::is_in_task()) {
+        throw std::invalid_argument("Error: function exit cannot be called in a parallel task");
+    }
     const LispValue& argument(evaluated_arguments[0]);
     if (argument.type == LispType::Unit) {
-        exit(0);
+        throw LispExit{ 0 };
     } else if (argument.type == LispType::Number) {
-        exit(argument.number);
+        throw LispExit{ argument.number };
     } else {
         throw std::invalid_argument("Error: function exit takes unit or number");
     }
 }
 
+LispValue builtin_symbol_stats(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    return _stats(evaluated_arguments, {
+        { "interned", LispSymbolTable::size() },
+    }, "symbol-stats");
+}
 
-inline LispValue _operator(
+LispValue builtin_alloc_stats(
     std::vector<LispValue>& evaluated_arguments,
-    const std::function<int(int)>& unary_op,
-    const std::function<int(int, int)>& binary_op,
-    const std::string& name
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    return _stats(evaluated_arguments, {
+        { "allocations", heap_allocations() },
+        { "calls",       evaluated_calls() },
+        { "bytes",       LispPool::bytes() },
+        { "live",        LispPool::live() },
+        { "peak",        LispPool::peak() },
+        { "reserved",    LispPool::reserved() },
+    }, "alloc-stats");
+}
+
+// The counts are those of the last collection, which runs between top-level forms only, so
+// environments that became garbage during the current form are still counted as tracked.
+LispValue builtin_gc_stats(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
 ) {
+    return _stats(evaluated_arguments, {
+        { "collections",  environment->collector().collections() },
+        { "environments", environment->collector().tracked() },
+        { "reclaimed",    environment->collector().reclaimed() },
+    }, "gc-stats");
+}
+
+LispValue builtin_cache_stats(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    const size_t hits = environment->cache_hits();
+    const size_t lookups = hits + environment->cache_misses();
+    return _stats(evaluated_arguments, {
+        { "hits",        hits },
+        { "misses",      lookups - hits },
+        { "hit-percent", lookups == 0 ? 0 : 100 * hits / lookups },
+    }, "cache-stats");
+}
+
+LispValue builtin_memo_stats(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (
+        evaluated_arguments.size() != 1 ||
+        evaluated_arguments[0].type != LispType::LambdaFunction ||
+        !evaluated_arguments[0].memo()
+    ) {
+        throw std::invalid_argument("Error: function memo-stats takes one memoized function");
+    }
+    const LispMemoTable& memo(*evaluated_arguments[0].memo());
+    return _counters({
+        { "hits",      memo.hits() },
+        { "misses",    memo.misses() },
+        { "entries",   memo.size() },
+        { "capacity",  memo.capacity() },
+        { "evictions", memo.evictions() },
+    });
+}
+
+
+inline LispValue _sum(std::vector<LispValue>& evaluated_arguments, bool is_subtraction, const char* name) {
     size_t num_args = evaluated_arguments.size();
     if (num_args < 1) {
-        throw std::invalid_argument("Error: operator " + name + " takes one or more arguments");
+        throw std::invalid_argument(
+            std::string("Error: operator ") + name + " takes one or more arguments");
     }
 
     LispValue& result(evaluated_arguments[0]);
     if (num_args == 1) {
+        if (result.type == LispType::Vector) return _packed_sum(evaluated_arguments, is_subtraction, name);
+        if (result.type == LispType::BigInteger) {
+            return is_subtraction ? LispValue(LispType::Number, -result.big_integer()) : result;
+        }
+        if (result.type == LispType::Float) {
+            return is_subtraction ? LispValue(LispType::Float, -result.real()) : result;
+        }
         if (result.type != LispType::Number) {
-            throw std::invalid_argument("Error: operator " + name + " takes numbers");
+            throw std::invalid_argument(std::string("Error: operator ") + name + " takes numbers");
         }
-        result.number = unary_op(result.number);
+        if (is_subtraction && result.number == std::numeric_limits<int>::min()) {
+            return LispValue(LispType::Number, -LispBigInteger(result.number));
+        }
+        if (is_subtraction) result.number = -result.number;
         return result;
     }
 
-    using cells_itr = std::vector<LispValue>::const_iterator;
-    const cells_itr begin = evaluated_arguments.begin() + 1, end = evaluated_arguments.end();
-
-    for (cells_itr itr = begin; itr != end; itr++) {
-        result.number = binary_op(result.number, itr->number);
+    const LispValue* rest = evaluated_arguments.data() + 1;
+    const LispValue* end = rest + (num_args - 1);
+    LispNumericSums sums;
+    if (result.type != LispType::Number || !sum_numbers(rest, end, sums)) {
+        if (any_type_of(evaluated_arguments, LispType::Vector)) {
+            return _packed_sum(evaluated_arguments, is_subtraction, name);
+        }
+        if (any_type_of(evaluated_arguments, LispType::Float)) {
+            if (!all_reals(evaluated_arguments)) {
+                throw std::invalid_argument(std::string("Error: operator ") + name + " takes numbers");
+            }
+            return is_subtraction
+                ? _real_operator<_real_sub>(evaluated_arguments, 1, _real_of(result))
+                : _real_operator<_real_add>(evaluated_arguments, 1, _real_of(result));
+        }
+        if (!all_numbers(evaluated_arguments)) {
+            throw std::invalid_argument(std::string("Error: operator ") + name + " takes numbers");
+        }
+        return is_subtraction
+            ? _big_operator<_big_sub>(evaluated_arguments, 1, _big_integer_of(result))
+            : _big_operator<_big_add>(evaluated_arguments, 1, _big_integer_of(result));
+    }
+
+    /* every partial sum lies between the first number plus the negative ones and plus the positive ones */
+    const long long first = result.number;
+    const long long lowest = is_subtraction ? first - sums.positive : first + sums.negative;
+    const long long highest = is_subtraction ? first - sums.negative : first + sums.positive;
+    if (lowest >= std::numeric_limits<int>::min() && highest <= std::numeric_limits<int>::max()) {
+        const long long total = sums.positive + sums.negative;
+        result.number = static_cast<int>(is_subtraction ? first - total : first + total);
+        return result;
     }
-    return result;
+
+    /* the result outgrows an int, but never 64 bits */
+    const long long total = sums.positive + sums.negative;
+    return LispValue(LispType::Number, LispBigInteger(is_subtraction ? first - total : first + total));
 }
 
-inline LispValue _operator(
-    std::vector<LispValue>& evaluated_arguments,
-    const std::function<int(int, int)>& binary_op,
-    const std::string& name
-) {
-    if (evaluated_arguments.size() < 2) {
-        throw std::invalid_argument("Error: operator " + name + " takes two or more arguments");
+/* operations are template arguments, so that each kernel is compiled with its operation inlined */
+template <bool (*binary_op)(int, int, int&), LispBigOperation big_op, LispRealOperation real_op>
+inline LispValue _operator(std::vector<LispValue>& evaluated_arguments, const char* name) {
+    const size_t num_args = evaluated_arguments.size();
+    if (num_args < 2) {
+        throw std::invalid_argument(
+            std::string("Error: operator ") + name + " takes two or more arguments");
     }
     if (!all_type_of(evaluated_arguments, LispType::Number)) {
-        throw std::invalid_argument("Error: operator " + name + " takes numbers");
+        if (any_type_of(evaluated_arguments, LispType::Vector)) {
+            return _packed<binary_op>(evaluated_arguments, name);
+        }
+        if (any_type_of(evaluated_arguments, LispType::Float)) {
+            /* operators without a floating-point counterpart, the logical ones, take integers */
+            if (real_op == nullptr) {
+                throw std::invalid_argument(std::string("Error: operator ") + name + " takes integers");
+            }
+            if (!all_reals(evaluated_arguments)) {
+                throw std::invalid_argument(std::string("Error: operator ") + name + " takes numbers");
+            }
+            return _real_operator<real_op>(evaluated_arguments, 1, _real_of(evaluated_arguments[0]));
+        }
+        if (!all_numbers(evaluated_arguments)) {
+            throw std::invalid_argument(std::string("Error: operator ") + name + " takes numbers");
+        }
+        return _big_operator<big_op>(evaluated_arguments, 1, _big_integer_of(evaluated_arguments[0]));
     }
 
-    using cells_itr = std::vector<LispValue>::const_iterator;
-    const cells_itr begin = evaluated_arguments.begin() + 1, end = evaluated_arguments.end();
-
     LispValue& result(evaluated_arguments[0]);
-    for (cells_itr itr = begin; itr != end; itr++) {
-        result.number = binary_op(result.number, itr->number);
+    for (size_t index = 1; index < num_args; index++) {
+        int number;
+        if (!binary_op(result.number, evaluated_arguments[index].number, number)) {
+            /* the result outgrows an int, so the rest goes on with big integers */
+            return _big_operator<big_op>(evaluated_arguments, index, LispBigInteger(result.number));
+        }
+        result.number = number;
     }
     return result;
 }
 
-inline LispValue _operator(
-    std::vector<LispValue>& evaluated_arguments,
-    const std::function<int(int)>& unary_op,
-    const std::string& name
-) {
+template <int (*unary_op)(int)>
+inline LispValue _operator(std::vector<LispValue>& evaluated_arguments, const char* name) {
     if (evaluated_arguments.size() != 1) {
-        throw std::invalid_argument("Error: operator " + name + " takes one argument");
+        throw std::invalid_argument(std::string("Error: operator ") + name + " takes one argument");
+    }
+    if (evaluated_arguments[0].type == LispType::Vector) {
+        const LispVectorView numbers(evaluated_arguments[0].numbers());
+        LispPackedNumbers result(numbers.begin(), numbers.end());
+        for (int& number : result) number = unary_op(number);
+        return LispValue(LispType::Vector, std::move(result));
+    }
+    if (evaluated_arguments[0].type == LispType::BigInteger) {
+        /* big integers are never zero, so they all act as one */
+        return LispValue(LispType::Number, unary_op(1));
     }
     if (evaluated_arguments[0].type != LispType::Number) {
-        throw std::invalid_argument("Error: operator " + name + " takes number");
+        throw std::invalid_argument(std::string("Error: operator ") + name + " takes number");
     }
 
     LispValue& result(evaluated_arguments[0]);
@@ -657,29 +1315,116 @@ inline LispValue _operator(
     return result;
 }
 
-inline LispValue _relation(
-    std::vector<LispValue>& evaluated_arguments,
-    const std::function<int(int, int)>& relation,
-    const std::string& name
-) {
+template <LispBigOperation big_op>
+inline LispValue _big_operator(std::vector<LispValue>& evaluated_arguments, size_t from, LispBigInteger&& result) {
+    for (size_t index = from, size = evaluated_arguments.size(); index < size; index++) {
+        result = big_op(result, _big_integer_of(evaluated_arguments[index]));
+    }
+    return LispValue(LispType::Number, std::move(result));
+}
+
+template <LispRealOperation real_op>
+inline LispValue _real_operator(std::vector<LispValue>& evaluated_arguments, size_t from, double result) {
+    for (size_t index = from, size = evaluated_arguments.size(); index < size; index++) {
+        result = real_op(result, _real_of(evaluated_arguments[index]));
+    }
+    return LispValue(LispType::Float, result);
+}
+
+inline LispValue _relation(std::vector<LispValue>& evaluated_arguments, LispOrder order, const char* name) {
     if (evaluated_arguments.size() < 2) {
-        throw std::invalid_argument("Error: relation " + name + " takes two or more arguments");
+        throw std::invalid_argument(
+            std::string("Error: relation ") + name + " takes two or more arguments");
     }
     if (!all_type_of(evaluated_arguments, LispType::Number)) {
-        throw std::invalid_argument("Error: relation " + name + " takes numbers");
+        if (!all_reals(evaluated_arguments)) {
+            throw std::invalid_argument(std::string("Error: relation ") + name + " takes numbers");
+        }
+        /* nan stands in no order to anything */
+        for (const LispValue& argument : evaluated_arguments) {
+            if (_is_nan(argument)) return LispValue(LispType::Number, 0);
+        }
+        for (size_t index = 1, size = evaluated_arguments.size(); index < size; index++) {
+            const int comparison = _compare_numbers(evaluated_arguments[index - 1], evaluated_arguments[index]);
+            if (!_is_in_order(comparison, order)) return LispValue(LispType::Number, 0);
+        }
+        return LispValue(LispType::Number, 1);
     }
 
-    using cells_itr = std::vector<LispValue>::const_iterator;
-    const cells_itr begin = evaluated_arguments.begin() + 1, end = evaluated_arguments.end();
+    const LispValue* begin = evaluated_arguments.data();
+    return LispValue(LispType::Number, is_ordered(begin, begin + evaluated_arguments.size(), order));
+}
+
+inline LispValue _packed_sum(std::vector<LispValue>& evaluated_arguments, bool is_subtraction, const char* name) {
+    LispPackedNumbers result(_spread(evaluated_arguments, name));
+    if (evaluated_arguments.size() == 1 && is_subtraction) {
+        for (int& number : result) number = _nega(number);
+    }
+
+    bool fits = true;
+    for (size_t index = 1, size = evaluated_arguments.size(); index < size && fits; index++) {
+        const LispValue& argument(evaluated_arguments[index]);
+        fits = argument.type == LispType::Vector
+            ? add_packed(result.data(), argument.numbers().data(), result.size(), is_subtraction)
+            : add_packed(result.data(), argument.number, result.size(), is_subtraction);
+    }
+    if (!fits) throw std::overflow_error("Error: overflow occurs");
+    return LispValue(LispType::Vector, std::move(result));
+}
+
+template <bool (*binary_op)(int, int, int&)>
+inline LispValue _packed(std::vector<LispValue>& evaluated_arguments, const char* name) {
+    /* vectors hold ints only, so a number outgrowing one is still an overflow there */
+    LispPackedNumbers result(_spread(evaluated_arguments, name));
+    bool fits = true;
+    for (size_t index = 1, size = evaluated_arguments.size(); index < size; index++) {
+        const LispValue& argument(evaluated_arguments[index]);
+        if (argument.type == LispType::Vector) {
+            const int* numbers = argument.numbers().data();
+            for (size_t at = 0; at < result.size(); at++) fits &= binary_op(result[at], numbers[at], result[at]);
+        } else {
+            for (int& number : result) fits &= binary_op(number, argument.number, number);
+        }
+        if (!fits) throw std::overflow_error("Error: overflow occurs");
+    }
+    return LispValue(LispType::Vector, std::move(result));
+}
+
+/* a number among vectors stands for a vector repeating it */
+inline LispPackedNumbers _spread(const std::vector<LispValue>& evaluated_arguments, const char* name) {
+    const LispValue* vector = nullptr;
+    for (const LispValue& argument : evaluated_arguments) {
+        if (argument.type == LispType::Vector) {
+            if (vector && argument.numbers().size() != vector->numbers().size()) {
+                throw std::invalid_argument(
+                    std::string("Error: operator ") + name + " takes vectors of the same length");
+            }
+            vector = &argument;
+        } else if (argument.type != LispType::Number) {
+            throw std::invalid_argument(std::string("Error: operator ") + name + " takes numbers or vectors");
+        }
+    }
+
+    const LispValue& first(evaluated_arguments[0]);
+    if (first.type == LispType::Number) return LispPackedNumbers(vector->numbers().size(), first.number);
+    return LispPackedNumbers(first.numbers().begin(), first.numbers().end());
+}
 
-    int result = 1;
-    for (cells_itr itr = begin; itr != end; itr++) {
-        if (!relation((itr - 1)->number, itr->number))  {
-            result = 0;
-            break;
+template <typename XIterator, typename YIterator>
+inline LispBigInteger _dot(XIterator x_itr, XIterator x_end, YIterator y_itr) {
+    LispBigInteger carried;
+    long long total = 0;
+    for (; x_itr != x_end; ++x_itr, ++y_itr) {
+        /* a product of two numbers always fits in 64 bits, a sum of them is carried once it does not */
+        const long long product = static_cast<long long>(_number_of(*x_itr)) * _number_of(*y_itr);
+        long long next;
+        if (__builtin_add_overflow(total, product, &next)) {
+            carried = carried + LispBigInteger(total);
+            next = product;
         }
+        total = next;
     }
-    return LispValue(LispType::Number, result);
+    return carried + LispBigInteger(total);
 }
 
 inline LispValue _ifdo(
@@ -700,90 +1445,120 @@ inline LispValue _ifdo(
         throw std::invalid_argument("Error: each statement is expected to be Q-Expression");
     }
 
-    LispValue result;
     if ((when_or_unless && !condition.number) || (!when_or_unless && condition.number)) {
-        return result;
+        return LispValue();
     }
-    for (LispValue& argument : evaluated_arguments) {
-        argument.type = LispType::S_Expression;
-        result = evaluate(argument, environment);
+    if (evaluated_arguments.empty()) return LispValue();
+    for (size_t index = 0, last = evaluated_arguments.size() - 1; index < last; index++) {
+        evaluated_arguments[index].type = LispType::S_Expression;
+        evaluate(evaluated_arguments[index], environment);
     }
-    return result;
+    evaluated_arguments.back().type = LispType::S_Expression;
+    return evaluate_tail(evaluated_arguments.back(), environment);
 }
 
-inline int _add(int x, int y) {
-    std::numeric_limits<int> limits;
-    if (
-        (x > 0 && y > 0 && x > limits.max() - y) ||
-        (x < 0 && y < 0 && x < limits.min() - y)
-    ) {
-        throw std::overflow_error("Error: overflow occurs");
+inline LispValue _stats(
+    std::vector<LispValue>& evaluated_arguments,
+    const std::vector<std::pair<std::string, size_t>>& counters,
+    const std::string& name
+) {
+    if (evaluated_arguments.size() != 1 || evaluated_arguments[0].type != LispType::Unit) {
+        throw std::invalid_argument("Error: function " + name + " takes one unit");
     }
-    return x + y;
+    return _counters(counters);
 }
 
-inline int _sub(int x, int y) {
-    std::numeric_limits<int> limits;
-    if (
-        (x > 0 && y < 0 && y < x - limits.max()) ||
-        (x < 0 && y > 0 && x < limits.min() + y)
-    ) {
-        throw std::overflow_error("Error: overflow occurs");
+// {{name count} ...}, with counts past the range of int as big integers
+inline LispValue _counters(const std::vector<std::pair<std::string, size_t>>& counters) {
+    std::vector<LispValue> entries;
+    for (const std::pair<std::string, size_t>& counter : counters) {
+        const uint64_t count = counter.second;
+        entries.push_back(LispValue(LispType::Q_Expression, {
+            LispValue(LispType::Symbol, counter.first),
+            LispValue(LispType::Number, LispBigInteger(false, {
+                static_cast<uint32_t>(count), static_cast<uint32_t>(count >> 32)
+            }))
+        }));
+    }
+    return LispValue(LispType::Q_Expression, entries);
+}
+
+// Calls function and finishes the tail call it may leave, for built-in functions that use
+// the result.
+inline LispValue _apply(
+    LispValue& function,
+    std::vector<LispValue>& arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    LispValue result = evaluate_call(function, arguments, environment);
+    LispValue tail_expression;
+    std::shared_ptr<LispEnvironment> tail_environment;
+    if (take_tail_call(tail_expression, tail_environment)) {
+        result = evaluate(tail_expression, tail_environment);
     }
-    return x - y;
+    return result;
 }
 
-inline int _mul(int x, int y) {
-    std::numeric_limits<int> limits;
-    if (
-        (x > 0 && y > 0 && x > limits.max() / y) ||
-        (x < 0 && y < 0 && x < limits.max() / y) ||
-        (x > 0 && y < 0 && y < limits.min() / x) ||
-        (x < 0 && y > 0 && x < limits.min() / y)
-    ) {
-        throw std::overflow_error("Error: overflow occurs");
+// Elements of a vector or Q-Expression, for the parallel built-in functions to index.
+inline std::vector<LispValue> _elements(const LispValue& list, const std::string& name) {
+    std::vector<LispValue> elements;
+    if (list.type == LispType::Vector) {
+        elements.reserve(list.numbers().size());
+        for (int number : list.numbers()) elements.push_back(LispValue(LispType::Number, number));
+    } else if (list.type == LispType::Q_Expression) {
+        elements.reserve(list.cells().size());
+        for (const LispValue& cell : list.cells()) elements.push_back(cell);
+    } else {
+        throw std::invalid_argument("Error: function " + name + " takes vector or Q-Expression");
     }
-    return x * y;
+    return elements;
+}
+
+// Runs task(begin, end) over consecutive chunks of [0, length) on the thread pool, with a few
+// chunks per thread so that threads finishing early steal the rest.
+template <typename Task>
+inline void _run_chunks(size_t length, const Task& task) {
+    const size_t chunks = std::min(length, LispThreadPool::threads() * 8);
+    LispThreadPool::run(chunks, [&](size_t chunk) {
+        task(chunk * length / chunks, (chunk + 1) * length / chunks);
+    });
+}
+
+inline bool _mul(int x, int y, int& result) {
+    return !__builtin_mul_overflow(x, y, &result);
 }
 
-inline int _div(int x, int y) {
+inline bool _div(int x, int y, int& result) {
     std::numeric_limits<int> limits;
     if (y == 0) {
         throw std::invalid_argument("Error: zero division is invalid");
     }
-    if (y == -1 && x == limits.min()) {
-         throw std::overflow_error("Error: overflow occurs");
-    }
-    return x / y;
+    if (y == -1 && x == limits.min()) return false;
+    result = x / y;
+    return true;
 }
 
-inline int _mod(int x, int y) {
-    std::numeric_limits<int> limits;
+inline bool _mod(int x, int y, int& result) {
     if (y == 0) {
         throw std::invalid_argument("Error: zero division is invalid");
     }
-    if (y == -1 && x == limits.min()) {
-         throw std::overflow_error("Error: overflow occurs");
-    }
-    return x % y;
+    result = y == -1 ? 0 : x % y;
+    return true;
 }
 
- inline int _pow(int x, int y) {
+inline bool _pow(int x, int y, int& result) {
     if (y < 0) {
         throw std::invalid_argument("Error: negative exponent is not supported");
     }
     int ret = 1;
     int temp = x;
     while (y > 0) {
-        if (y % 2 == 1) ret = _mul(ret, temp);
-        temp = _mul(temp, temp);
+        if (y % 2 == 1 && !_mul(ret, temp, ret)) return false;
         y /= 2;
+        if (y > 0 && !_mul(temp, temp, temp)) return false;
     }
-    return ret;
-}
-
-inline int _posi(int x) {
-    return x;
+    result = ret;
+    return true;
 }
 
 inline int _nega(int x) {
@@ -792,37 +1567,182 @@ inline int _nega(int x) {
     return -x;
 }
 
-inline int _and(int x, int y) {
-    return x && y;
+inline bool _and(int x, int y, int& result) {
+    result = x && y;
+    return true;
 }
 
-inline int _or(int x, int y) {
-    return x || y;
+inline bool _or(int x, int y, int& result) {
+    result = x || y;
+    return true;
 }
 
 inline int _not(int x) {
     return !x;
 }
 
-inline int _gt(int x, int y) {
-    return x > y;
+inline LispBigInteger _big_add(const LispBigInteger& x, const LispBigInteger& y) {
+    return x + y;
+}
+
+inline LispBigInteger _big_sub(const LispBigInteger& x, const LispBigInteger& y) {
+    return x - y;
+}
+
+inline LispBigInteger _big_mul(const LispBigInteger& x, const LispBigInteger& y) {
+    return x * y;
+}
+
+inline LispBigInteger _big_div(const LispBigInteger& x, const LispBigInteger& y) {
+    return x / y;
+}
+
+inline LispBigInteger _big_mod(const LispBigInteger& x, const LispBigInteger& y) {
+    return x % y;
+}
+
+inline LispBigInteger _big_pow(const LispBigInteger& x, const LispBigInteger& y) {
+    if (y.is_negative()) {
+        throw std::invalid_argument("Error: negative exponent is not supported");
+    }
+    if (!y.fits_int()) {
+        throw std::invalid_argument("Error: exponent is too large");
+    }
+    return x.pow(y.to_int());
+}
+
+inline LispBigInteger _big_and(const LispBigInteger& x, const LispBigInteger& y) {
+    return LispBigInteger(!x.is_zero() && !y.is_zero());
+}
+
+inline LispBigInteger _big_or(const LispBigInteger& x, const LispBigInteger& y) {
+    return LispBigInteger(!x.is_zero() || !y.is_zero());
+}
+
+/* floating-point division and remainder by zero follow IEEE 754, giving infinities and nan */
+inline double _real_add(double x, double y) {
+    return x + y;
+}
+
+inline double _real_sub(double x, double y) {
+    return x - y;
+}
+
+inline double _real_mul(double x, double y) {
+    return x * y;
+}
+
+inline double _real_div(double x, double y) {
+    return x / y;
+}
+
+inline double _real_mod(double x, double y) {
+    return std::fmod(x, y);
+}
+
+inline double _real_pow(double x, double y) {
+    return std::pow(x, y);
+}
+
+inline int _number_of(const LispValue& value) {
+    return value.number;
+}
+
+inline int _number_of(int number) {
+    return number;
+}
+
+inline LispBigInteger _big_integer_of(const LispValue& value) {
+    return value.type == LispType::Number ? LispBigInteger(value.number) : value.big_integer();
+}
+
+// An integral, finite value.
+inline LispBigInteger _big_integer_of(double value) {
+    if (std::fabs(value) < 9223372036854775808.0) return LispBigInteger(static_cast<int64_t>(value));
+    int exponent;
+    const double fraction = std::frexp(value, &exponent);
+    const LispBigInteger mantissa(static_cast<int64_t>(std::ldexp(fraction, 53)));
+    return mantissa * LispBigInteger(2).pow(exponent - 53);
+}
+
+inline double _real_of(const LispValue& value) {
+    switch (value.type) {
+        case LispType::Number:
+            return value.number;
+        case LispType::BigInteger:
+            return value.big_integer().to_double();
+        default:
+            return value.real();
+    }
 }
 
-inline int _geq(int x, int y) {
-    return x >= y;
+inline bool _is_nan(const LispValue& value) {
+    return value.type == LispType::Float && std::isnan(value.real());
 }
 
-inline int _lt(int x, int y) {
-    return x < y;
+// -1, 0 or 1 as x is less than, equal to or greater than y, exactly, for any numbers but nan.
+inline int _compare_numbers(const LispValue& x, const LispValue& y) {
+    if (x.type != LispType::Float && y.type != LispType::Float) {
+        return compare(_big_integer_of(x), _big_integer_of(y));
+    }
+    if (x.type == LispType::BigInteger) return -_compare_numbers(y, x);
+    if (y.type == LispType::BigInteger) {
+        /* rounding keeps the order, so only a tie needs the exact integer, which the double then is */
+        const double real = x.real(), rounded = y.big_integer().to_double();
+        if (std::isinf(real)) return real < 0 ? -1 : 1;
+        if (real != rounded) return real < rounded ? -1 : 1;
+        return compare(_big_integer_of(real), y.big_integer());
+    }
+    /* every int is exact as a double */
+    const double real_x = _real_of(x), real_y = _real_of(y);
+    return real_x < real_y ? -1 : real_x > real_y ? 1 : 0;
 }
 
-inline int _leq(int x, int y) {
-    return x < y;
+inline bool _is_in_order(int comparison, LispOrder order) {
+    switch (order) {
+        case LispOrder::Less:
+            return comparison < 0;
+        case LispOrder::LessEqual:
+            return comparison <= 0;
+        case LispOrder::Greater:
+            return comparison > 0;
+        case LispOrder::GreaterEqual:
+            return comparison >= 0;
+        default:
+            return false;
+    }
 }
 
-inline bool all_type_of(const std::vector<LispValue>& cells, LispType type) {
+template<typename Cells>
+inline bool all_type_of(const Cells& cells, LispType type) {
     for (const LispValue& value : cells) {
         if (value.type != type) return false;
     }
     return true;
 }
+
+template<typename Cells>
+inline bool all_numbers(const Cells& cells) {
+    for (const LispValue& value : cells) {
+        if (value.type != LispType::Number && value.type != LispType::BigInteger) return false;
+    }
+    return true;
+}
+
+template<typename Cells>
+inline bool all_reals(const Cells& cells) {
+    for (const LispValue& value : cells) {
+        if (value.type != LispType::Number && value.type != LispType::BigInteger && value.type != LispType::Float) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Cells>
+inline bool any_type_of(const Cells& cells, LispType type) {
+    for (const LispValue& value : cells) {
+        if (value.type == type) return true;
+    }
+    return false;
+}
@@ -0,0 +1,182 @@
+#include "bytecode.hpp"
+
+#include "evaluation.hpp"
+#include "lispvalue.hpp"
+#include "profile.hpp"
+
+
+enum class LispOpcode {
+    Constant,   // push constants[operand]
+    Resolve,    // push the value bound to the symbol constants[operand]
+    Call,       // call the function under operand arguments, push the result
+    TailCall,   // call the function under operand arguments in place of this code
+    Return,     // return the top of the stack
+};
+
+struct LispInstruction {
+    LispOpcode opcode;
+    int operand;
+};
+
+// Instructions of one S-Expression, owned by the first cell of its list.
+class LispCode : public LispObject {
+    public:
+        std::vector<LispInstruction> instructions;
+        std::vector<LispValue> constants;
+};
+
+
+// Operand stack shared by nested executions, each working above its own base.
+class LispStackFrame {
+    public:
+        std::vector<LispValue>& stack;
+        const size_t base;
+
+        LispStackFrame(std::vector<LispValue>& _stack): stack(_stack), base(_stack.size()) {}
+        ~LispStackFrame() { stack.erase(stack.begin() + base, stack.end()); }
+};
+
+// Value to compile, or the call to make when value is null.
+struct LispCompileStep {
+    const LispValue* value;
+    bool is_tail;
+    int arguments;
+};
+
+static thread_local std::vector<LispValue> operand_stack;
+
+
+inline const LispCode* compiled_code(const LispValue& sexpr);
+inline void compile_value(const LispValue& value, bool is_tail, LispCode& code);
+inline int add_constant(const LispValue& value, LispCode& code);
+
+
+LispValue execute(
+    const LispValue& sexpr,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    LispProfileScope profile_scope;
+    if (sexpr.cells().empty()) return LispValue();
+
+    /* the expression keeps its code alive across tail calls */
+    LispValue expression(sexpr);
+    std::shared_ptr<LispEnvironment> current_environment(environment);
+    const LispCode* code = compiled_code(expression);
+    size_t pc = 0;
+
+    LispStackFrame frame(operand_stack);
+    std::vector<LispValue>& stack(frame.stack);
+    while (true) {
+        const LispInstruction& instruction = code->instructions[pc++];
+        switch (instruction.opcode) {
+            case LispOpcode::Constant:
+                stack.push_back(code->constants[instruction.operand]);
+                break;
+            case LispOpcode::Resolve:
+                stack.push_back(current_environment->resolve(code->constants[instruction.operand]));
+                break;
+            case LispOpcode::Call:
+            case LispOpcode::TailCall: {
+                const std::vector<LispValue>::iterator first = stack.end() - instruction.operand;
+                std::vector<LispValue> arguments(
+                    std::make_move_iterator(first), std::make_move_iterator(stack.end()));
+                stack.erase(first, stack.end());
+                LispValue function(std::move(stack.back()));
+                stack.pop_back();
+
+                LispValue result = evaluate_call(function, arguments, current_environment);
+
+                LispValue tail_expression;
+                std::shared_ptr<LispEnvironment> tail_environment;
+                if (take_tail_call(tail_expression, tail_environment)) {
+                    if (
+                        instruction.opcode == LispOpcode::TailCall &&
+                        tail_expression.type == LispType::S_Expression &&
+                        !tail_expression.cells().empty()
+                    ) {
+                        /* continue with the callee's code in this C++ frame */
+                        expression = std::move(tail_expression);
+                        current_environment = std::move(tail_environment);
+                        code = compiled_code(expression);
+                        pc = 0;
+                        stack.erase(stack.begin() + frame.base, stack.end());
+                        profile_scope.tail_call();
+                        break;
+                    }
+                    result = evaluate(tail_expression, tail_environment);
+                }
+
+                if (instruction.opcode == LispOpcode::TailCall) return result;
+                stack.push_back(std::move(result));
+                break;
+            }
+            case LispOpcode::Return: {
+                LispValue result(std::move(stack.back()));
+                stack.pop_back();
+                return result;
+            }
+        }
+    }
+}
+
+
+inline const LispCode* compiled_code(const LispValue& sexpr) {
+    const LispObject* compiled = sexpr.compiled();
+    if (compiled) return static_cast<const LispCode*>(compiled);
+
+    LispCode* code = new LispCode();
+    compile_value(sexpr, true, *code);
+    code->instructions.push_back({ LispOpcode::Return, 0 });
+    return static_cast<const LispCode*>(sexpr.set_compiled(code));
+}
+
+inline void compile_value(const LispValue& value, bool is_tail, LispCode& code) {
+    /* values left to compile, last first, and the calls to make once their arguments are;
+       without recursion, so that deeply nested expressions do not overflow the stack */
+    std::vector<LispCompileStep> steps{ LispCompileStep{ &value, is_tail, 0 } };
+    std::vector<const LispValue*> cells;
+    while (!steps.empty()) {
+        const LispCompileStep step(steps.back());
+        steps.pop_back();
+        if (!step.value) {
+            code.instructions.push_back({
+                step.is_tail ? LispOpcode::TailCall : LispOpcode::Call, step.arguments
+            });
+            continue;
+        }
+
+        switch (step.value->type) {
+            case LispType::Symbol:
+                code.instructions.push_back({ LispOpcode::Resolve, add_constant(*step.value, code) });
+                break;
+            case LispType::S_Expression: {
+                const LispCells list(step.value->cells());
+                if (list.size() == 0) {
+                    code.instructions.push_back({ LispOpcode::Constant, add_constant(LispValue(), code) });
+                    break;
+                }
+                if (list.size() == 1) {
+                    steps.push_back(LispCompileStep{ &list.front(), step.is_tail, 0 });
+                    break;
+                }
+
+                /* the function and its arguments are evaluated left to right, then called */
+                steps.push_back(LispCompileStep{ nullptr, step.is_tail, static_cast<int>(list.size() - 1) });
+                cells.clear();
+                for (const LispValue& cell : list) cells.push_back(&cell);
+                for (auto cell = cells.rbegin(); cell != cells.rend(); ++cell) {
+                    steps.push_back(LispCompileStep{ *cell, false, 0 });
+                }
+                break;
+            }
+            default:
+                code.instructions.push_back({ LispOpcode::Constant, add_constant(*step.value, code) });
+                break;
+        }
+    }
+}
+
+inline int add_constant(const LispValue& value, LispCode& code) {
+    code.constants.push_back(value);
+    return static_cast<int>(code.constants.size() - 1);
+}
@@ -0,0 +1,14 @@
+#ifndef _BYTECODE_HPP_
+#define _BYTECODE_HPP_
+
+
+#include "lispvalue.hpp"
+
+
+// Runs an S-Expression on the stack machine, compiling it on first use.
+LispValue execute(
+    const LispValue& sexpr,
+    const std::shared_ptr<LispEnvironment>& environment
+);
+
+#endif  // _BYTECODE_HPP_
@@ -1,13 +1,31 @@
 #include "evaluation.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include "builtin.hpp"
+#include "bytecode.hpp"
 #include "lispvalue.hpp"
+#include "memo.hpp"
+#include "profile.hpp"
+
+
+// Expression left by evaluate_tail, which evaluate() runs after the call that set it returns.
+struct LispTailCall {
+    bool pending;
+    LispValue expression;
+    std::shared_ptr<LispEnvironment> environment;
+};
+
+static thread_local LispTailCall tail_call = { false, LispValue(), std::shared_ptr<LispEnvironment>() };
+static LispEngine selected_engine = LispEngine::TreeWalker;
+static thread_local size_t call_count = 0;
+static std::atomic<size_t> folded_calls(0);
+static std::atomic<unsigned long> last_scope(0);
 
 
 inline void add_builtin_function(
     const std::string& name,
-    const LispBuiltinFunction& function,
+    LispBuiltinFunction function,
     const std::shared_ptr<LispEnvironment>& environment
 );
 inline LispValue evaluate_symbol(
@@ -20,18 +38,48 @@ inline LispValue evaluate_sexpr(
 );
 inline LispValue evaluate_lambda_function_call(
     LispValue& lambda_function,
-    const std::vector<LispValue>& evaluated_arguments
+    std::vector<LispValue>& evaluated_arguments
+);
+inline LispValue evaluate_memoized_call(
+    const LispValue& lambda_function,
+    const std::vector<LispValue>& arguments
+);
+inline LispValue evaluate_profiled_call(
+    LispValue& function,
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+);
+inline LispValue resolve_lexical_addresses(
+    const LispValue& value,
+    const LispValue& params,
+    unsigned long scope,
+    const std::shared_ptr<LispEnvironment>& environment
+);
+inline LispLexicalAddress lexical_address_of(
+    int symbol_id,
+    const LispValue& params,
+    unsigned long scope,
+    const std::shared_ptr<LispEnvironment>& environment
 );
 
 
-std::shared_ptr<LispEnvironment> global_environment() {
-    std::shared_ptr<LispEnvironment> environment(new LispEnvironment());
+void select_engine(LispEngine engine) {
+    selected_engine = engine;
+}
+
+std::shared_ptr<LispEnvironment> global_environment(
+    LispCollector& collector,
+    std::ostream& output,
+    std::ostream& errors
+) {
+    std::shared_ptr<LispEnvironment> environment(new LispEnvironment(collector, output, errors));
 
-    environment->define_global("unit",        LispValue(),                              true);
-    environment->define_global("true",        LispValue(LispType::Number, 1),           true);
-    environment->define_global("false",       LispValue(LispType::Number, 0),           true);
-    environment->define_global("nil",         LispValue(LispType::Q_Expression),        true);
-    environment->define_global("otherwise",   LispValue(LispType::Symbol, "otherwise"), true);
+    const LispValue otherwise(LispType::Symbol, "otherwise");
+    environment->define_global(LispSymbolTable::intern("unit"),      LispValue(),                       true);
+    environment->define_global(LispSymbolTable::intern("true"),      LispValue(LispType::Number, 1),    true);
+    environment->define_global(LispSymbolTable::intern("false"),     LispValue(LispType::Number, 0),    true);
+    environment->define_global(LispSymbolTable::intern("nil"),       LispValue(LispType::Q_Expression), true);
+    environment->define_global(otherwise.symbol_id(),                otherwise,                         true);
 
     add_builtin_function("+", builtin_add, environment);
     add_builtin_function("-", builtin_sub, environment);
@@ -39,6 +87,8 @@ std::shared_ptr<LispEnvironment> global_environment() {
     add_builtin_function("/", builtin_div, environment);
     add_builtin_function("%", builtin_mod, environment);
     add_builtin_function("^", builtin_pow, environment);
+    add_builtin_function("sum", builtin_sum, environment);
+    add_builtin_function("dot", builtin_dot, environment);
 
     add_builtin_function("list", builtin_list, environment);
     add_builtin_function("cons", builtin_cons, environment);
@@ -47,6 +97,17 @@ std::shared_ptr<LispEnvironment> global_environment() {
     add_builtin_function("tail", builtin_tail, environment);
     add_builtin_function("join", builtin_join, environment);
     add_builtin_function("len",  builtin_len,  environment);
+    add_builtin_function("map",  builtin_map,  environment);
+    add_builtin_function("pmap",    builtin_pmap,    environment);
+    add_builtin_function("pfilter", builtin_pfilter, environment);
+    add_builtin_function("preduce", builtin_preduce, environment);
+    add_builtin_function("nth",   builtin_nth,   environment);
+    add_builtin_function("slice", builtin_slice, environment);
+
+    add_builtin_function("vector",    builtin_vector,    environment);
+    add_builtin_function("range",     builtin_range,     environment);
+    add_builtin_function("to-vector", builtin_to_vector, environment);
+    add_builtin_function("to-list",   builtin_to_list,   environment);
 
     add_builtin_function("if",     builtin_if,     environment);
     add_builtin_function("cond",   builtin_cond,   environment);
@@ -64,98 +125,177 @@ std::shared_ptr<LispEnvironment> global_environment() {
     add_builtin_function("<",    builtin_lt,   environment);
     add_builtin_function("<=",   builtin_leq,  environment);
 
-    add_builtin_function("lambda", builtin_lambda, environment);
-    add_builtin_function("def",    builtin_def,    environment);
-    add_builtin_function("defun",  builtin_defun,  environment);
-    add_builtin_function("del",    builtin_del,    environment);
+    add_builtin_function("lambda",  builtin_lambda,  environment);
+    add_builtin_function("def",     builtin_def,     environment);
+    add_builtin_function("defun",   builtin_defun,   environment);
+    add_builtin_function("memoize", builtin_memoize, environment);
+    add_builtin_function("del",     builtin_del,     environment);
 
     add_builtin_function("do",    builtin_do,      environment);
     add_builtin_function("print", builtin_print,   environment);
     add_builtin_function("type",  builtin_type,    environment);
+    add_builtin_function("load",  builtin_load,    environment);
+    add_builtin_function("save-image", builtin_save_image, environment);
+    add_builtin_function("load-image", builtin_load_image, environment);
     add_builtin_function("exit",  builtin_exit,    environment);
 
+    add_builtin_function("symbol-stats", builtin_symbol_stats, environment);
+    add_builtin_function("alloc-stats",  builtin_alloc_stats,  environment);
+    add_builtin_function("gc-stats",     builtin_gc_stats,     environment);
+    add_builtin_function("cache-stats",  builtin_cache_stats,  environment);
+    add_builtin_function("memo-stats",   builtin_memo_stats,   environment);
+
     return environment;
 }
 
+LispValue make_lambda_function(
+    const LispValue& params,
+    const LispValue& body,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    const unsigned long scope = new_lambda_scope();
+    return LispValue(
+        LispType::LambdaFunction,
+        params,
+        resolve_lexical_addresses(body, params, scope, environment),
+        environment,
+        scope
+    );
+}
+
+unsigned long new_lambda_scope() {
+    return ++last_scope;
+}
+
 LispValue evaluate(
-    LispValue& value,
+    const LispValue& value,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    switch (value.type) {
-        case LispType::Unit:
-        case LispType::Number:
-        case LispType::String:
-            /* End of evaluation */
-            return value;
-        case LispType::Symbol:
-            return evaluate_symbol(value, environment);
-        case LispType::BuiltinFunction:
-        case LispType::LambdaFunction:
-            /* End of evaluation */
-            return value;
-        case LispType::S_Expression:
-            return evaluate_sexpr(value, environment);
-        case LispType::Q_Expression:
-            /* Stop evaluation */
-            return value;
-        default:
-            throw std::invalid_argument("Error: Unknown type");
+    if (selected_engine == LispEngine::Bytecode && value.type == LispType::S_Expression) {
+        return execute(value, environment);
+    }
+
+    LispValue expression(value);
+    std::shared_ptr<LispEnvironment> current_environment(environment);
+    LispProfileScope profile_scope;
+    while (true) {
+        switch (expression.type) {
+            case LispType::Unit:
+            case LispType::Number:
+            case LispType::String:
+            case LispType::Vector:
+            case LispType::BigInteger:
+            case LispType::Float:
+                /* End of evaluation */
+                return expression;
+            case LispType::Symbol:
+                return evaluate_symbol(expression, current_environment);
+            case LispType::BuiltinFunction:
+            case LispType::LambdaFunction:
+                /* End of evaluation */
+                return expression;
+            case LispType::S_Expression: {
+                LispValue result = evaluate_sexpr(expression, current_environment);
+                /* continue with the tail expression in this C++ frame */
+                if (!take_tail_call(expression, current_environment)) return result;
+                profile_scope.tail_call();
+                break;
+            }
+            case LispType::Q_Expression:
+                /* Stop evaluation */
+                return expression;
+            default:
+                throw std::invalid_argument("Error: Unknown type");
+        }
     }
 }
 
+LispValue evaluate_tail(
+    const LispValue& value,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    tail_call.pending = true;
+    tail_call.expression = value;
+    tail_call.environment = environment;
+    return LispValue();
+}
+
+LispValue evaluate_call(
+    LispValue& function,
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    call_count++;
+    if (LispProfiler::is_enabled()) return evaluate_profiled_call(function, evaluated_arguments, environment);
+    if (function.type == LispType::BuiltinFunction) {
+        return function.builtin_function()(evaluated_arguments, environment);
+    } else if (function.type == LispType::LambdaFunction) {
+        return evaluate_lambda_function_call(function, evaluated_arguments);
+    }
+    throw std::invalid_argument("Error: S-Expression does not start with function");
+}
+
+size_t evaluated_calls() {
+    return folded_calls.load() + call_count;
+}
+
+void fold_thread_calls() {
+    folded_calls += call_count;
+    call_count = 0;
+}
+
+bool take_tail_call(LispValue& expression, std::shared_ptr<LispEnvironment>& environment) {
+    if (!tail_call.pending) return false;
+    tail_call.pending = false;
+    expression = std::move(tail_call.expression);
+    environment = std::move(tail_call.environment);
+    return true;
+}
+
 
 inline void add_builtin_function(
     const std::string& symbol,
-    const LispBuiltinFunction& function,
+    LispBuiltinFunction function,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
     environment->define_global(
-        symbol, LispValue(LispType::BuiltinFunction, function, symbol), true);
+        LispSymbolTable::intern(symbol), LispValue(LispType::BuiltinFunction, function, symbol), true);
 }
 
 inline LispValue evaluate_symbol(
     LispValue& value,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    return environment->resolve(value.symbol);
+    return environment->resolve(value);
 }
 
 inline LispValue evaluate_sexpr(
     LispValue& value,
     const std::shared_ptr<LispEnvironment>& environment
 ) {
-    const int num_cells = value.cells.size();
-    for (LispValue& cell : value.cells) {
-        cell = evaluate(cell, environment);
-    }
-
-    if (num_cells == 0) return LispValue();
-    if (num_cells == 1) return value.cells[0];
+    const LispCells cells(value.cells());
+    if (cells.size() == 0) return LispValue();
+    if (cells.size() == 1) return evaluate_tail(cells.front(), environment);
 
-    LispValue function(value.cells[0]);
-    if (
-        function.type != LispType::BuiltinFunction &&
-        function.type != LispType::LambdaFunction
-    ) {
-        throw std::invalid_argument("Error: S-Expression does not start with function");
-    }
+    LispCells::iterator cell = cells.begin();
+    LispValue function(evaluate(*cell, environment));
 
-    value.cells.erase(value.cells.begin());
-    if (function.type == LispType::BuiltinFunction) {
-        return function.builtin_function(value.cells, environment);
-    } else {
-        return evaluate_lambda_function_call(function, value.cells);
+    std::vector<LispValue> evaluated_arguments;
+    evaluated_arguments.reserve(cells.size() - 1);
+    for (++cell; cell != cells.end(); ++cell) {
+        evaluated_arguments.push_back(evaluate(*cell, environment));
     }
+    return evaluate_call(function, evaluated_arguments, environment);
 }
 
 inline LispValue evaluate_lambda_function_call(
     LispValue& lambda_function,
-    const std::vector<LispValue>& evaluated_arguments
+    std::vector<LispValue>& evaluated_arguments
 ) {
-    std::vector<LispValue>& params(lambda_function.cells[0].cells);
-    LispValue& body(lambda_function.cells[1]);
+    const std::vector<LispValue>& bound_arguments(lambda_function.bound_arguments());
 
-    size_t expected_num = params.size(), given_num = evaluated_arguments.size();
+    size_t expected_num = lambda_function.params().cells().size() - bound_arguments.size();
+    size_t given_num = evaluated_arguments.size();
     if (expected_num == 0) {
         if (given_num != 0 && (given_num != 1 || evaluated_arguments[0].type != LispType::Unit)) {
             throw std::invalid_argument("Error: lambda function takes one unit");
@@ -168,17 +308,158 @@ inline LispValue evaluate_lambda_function_call(
         );
     }
 
-    std::shared_ptr<LispEnvironment> local_env(new LispEnvironment(*lambda_function.local_environment));
-    for (size_t index = 0; index < given_num; index++) {
-        local_env->define_local(params[index].symbol, evaluated_arguments[index]);
+    /* without bound arguments the evaluated ones become the frame as they are */
+    std::vector<LispValue> arguments;
+    if (bound_arguments.empty()) {
+        evaluated_arguments.resize(given_num);
+        arguments.swap(evaluated_arguments);
+    } else {
+        arguments.reserve(bound_arguments.size() + given_num);
+        arguments.insert(arguments.end(), bound_arguments.begin(), bound_arguments.end());
+        arguments.insert(
+            arguments.end(), evaluated_arguments.begin(), evaluated_arguments.begin() + given_num);
+    }
+
+    if (expected_num != given_num) {
+        return LispValue(LispType::LambdaFunction, lambda_function, arguments);
+    }
+
+    if (lambda_function.memo()) return evaluate_memoized_call(lambda_function, arguments);
+
+    /* the call frame is a flat array of arguments over the closure */
+    std::shared_ptr<LispEnvironment> local_env(std::allocate_shared<LispEnvironment>(
+        LispPoolAllocator<LispEnvironment>(),
+        lambda_function.local_environment(),
+        lambda_function.params(),
+        lambda_function.scope(),
+        std::move(arguments)
+    ));
+    LispValue sexpr(lambda_function.body());
+    sexpr.type = LispType::S_Expression;
+    return evaluate_tail(sexpr, local_env);
+}
+
+// Same for a call with every argument of a memoized function, whose body is evaluated here
+// rather than in a tail call, so as to remember the result.
+inline LispValue evaluate_memoized_call(
+    const LispValue& lambda_function,
+    const std::vector<LispValue>& arguments
+) {
+    LispMemoTable& memo(*lambda_function.memo());
+    LispValue result;
+    if (memo.find(arguments, result)) return result;
+
+    std::shared_ptr<LispEnvironment> local_env(std::allocate_shared<LispEnvironment>(
+        LispPoolAllocator<LispEnvironment>(),
+        lambda_function.local_environment(),
+        lambda_function.params(),
+        lambda_function.scope(),
+        std::vector<LispValue>(arguments)
+    ));
+    LispValue sexpr(lambda_function.body());
+    sexpr.type = LispType::S_Expression;
+    result = evaluate(sexpr, local_env);
+    memo.insert(arguments, result);
+    return result;
+}
+
+// Same as evaluate_call, in the frame of the function.
+inline LispValue evaluate_profiled_call(
+    LispValue& function,
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    if (function.type == LispType::BuiltinFunction) {
+        LispProfileFrame frame(function);
+        return function.builtin_function()(evaluated_arguments, environment);
+    } else if (function.type == LispType::LambdaFunction) {
+        /* the body left as a tail call enters the frame where it is evaluated */
+        LispProfiler::expect_call(function);
+        LispValue result;
+        try {
+            result = evaluate_lambda_function_call(function, evaluated_arguments);
+        } catch (...) {
+            LispProfiler::end_call();
+            throw;
+        }
+        if (!tail_call.pending) LispProfiler::end_call();
+        return result;
+    }
+    throw std::invalid_argument("Error: S-Expression does not start with function");
+}
+
+inline LispValue resolve_lexical_addresses(
+    const LispValue& value,
+    const LispValue& params,
+    unsigned long scope,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    /* lists being copied, innermost last, with the cells resolved so far; without recursion,
+       so that deeply nested bodies do not overflow the stack */
+    struct Frame {
+        LispType type;
+        LispCells::iterator next;
+        std::vector<LispValue> cells;
+    };
+    std::vector<Frame> frames;
+    const LispValue* next = &value;
+    while (true) {
+        switch (next->type) {
+            case LispType::Symbol: {
+                LispValue symbol(
+                    LispType::Symbol,
+                    next->symbol_id(),
+                    lexical_address_of(next->symbol_id(), params, scope, environment)
+                );
+                if (frames.empty()) return symbol;
+                frames.back().cells.push_back(std::move(symbol));
+                break;
+            }
+            case LispType::S_Expression:
+            case LispType::Q_Expression:
+                /* quoted code is resolved too, since control flow evaluates it in this frame */
+                frames.push_back(Frame{ next->type, next->cells().begin(), std::vector<LispValue>() });
+                frames.back().cells.reserve(next->cells().size());
+                break;
+            default:
+                if (frames.empty()) return *next;
+                frames.back().cells.push_back(*next);
+        }
+
+        /* lists whose cells are all resolved go into the list holding them */
+        while (frames.back().next == LispCells::iterator(nullptr)) {
+            LispValue list(frames.back().type, frames.back().cells);
+            frames.pop_back();
+            if (frames.empty()) return list;
+            frames.back().cells.push_back(std::move(list));
+        }
+        next = &*frames.back().next;
+        ++frames.back().next;
     }
+}
 
-    if (expected_num == given_num) {
-        body.type = LispType::S_Expression;
-        return evaluate(body, local_env);
+inline LispLexicalAddress lexical_address_of(
+    int symbol_id,
+    const LispValue& params,
+    unsigned long scope,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    int found = -1, slot = 0;
+    for (const LispValue& param : params.cells()) {
+        if (param.symbol_id() == symbol_id) found = slot;
+        slot++;
     }
+    if (found >= 0) return { scope, 0, found };
 
-    params.erase(params.begin(), params.begin() + given_num);
-    lambda_function.local_environment = local_env;
-    return lambda_function;
+    /* frames are never modified once created, so the closure's bindings are final */
+    int depth = 1;
+    for (
+        const LispEnvironment* frame = environment.get();
+        frame->parent_environment();
+        frame = frame->parent_environment().get(), depth++
+    ) {
+        const int frame_slot = frame->find_slot(symbol_id);
+        if (frame_slot >= 0) return { scope, depth, frame_slot };
+    }
+    return { scope, -1, 0 };
 }
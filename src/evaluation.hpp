@@ -5,10 +5,52 @@
 #include "lispvalue.hpp"
 
 
-std::shared_ptr<LispEnvironment> global_environment();
+enum class LispEngine {
+    TreeWalker,
+    Bytecode,
+};
+
+void select_engine(LispEngine engine);
+// Global environment with every built-in function, tracked by collector, printing to output
+// and reporting errors of top-level forms to errors.
+std::shared_ptr<LispEnvironment> global_environment(
+    LispCollector& collector,
+    std::ostream& output,
+    std::ostream& errors
+);
+LispValue make_lambda_function(
+    const LispValue& params,
+    const LispValue& body,
+    const std::shared_ptr<LispEnvironment>& environment
+);
+// Scope id that no lambda function has been made with yet.
+unsigned long new_lambda_scope();
 LispValue evaluate(
-    LispValue& value,
+    const LispValue& value,
+    const std::shared_ptr<LispEnvironment>& environment
+);
+
+// Evaluates value in tail position: the caller must return the result as it is.
+LispValue evaluate_tail(
+    const LispValue& value,
     const std::shared_ptr<LispEnvironment>& environment
 );
 
+// Calls function on evaluated arguments; the call may leave a tail call behind.
+LispValue evaluate_call(
+    LispValue& function,
+    std::vector<LispValue>& evaluated_arguments,
+    const std::shared_ptr<LispEnvironment>& environment
+);
+
+// Function calls made through evaluate_call since the start of the program, by the calling
+// thread and by the ones that have folded theirs in.
+size_t evaluated_calls();
+
+// Adds the calls of the calling thread to the ones of the others, which are counted apart.
+void fold_thread_calls();
+
+// Takes over the tail call left by evaluate_tail, if there is one.
+bool take_tail_call(LispValue& expression, std::shared_ptr<LispEnvironment>& environment);
+
 #endif  // _EVALUATION_HPP_
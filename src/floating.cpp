@@ -0,0 +1,421 @@
+#include "floating.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "bignum.hpp"
+
+
+using uint128 = unsigned __int128;
+
+static const int mantissa_bits = 52;
+static const int exponent_bias = 1023;
+
+/* decimal exponents of the powers of five the parser keeps, outside which values are zero or infinite */
+static const int smallest_power_of_ten = -342;
+static const int largest_power_of_ten = 308;
+
+/* every significand of up to 19 digits fits 64 bits */
+static const int significant_digits = 19;
+
+/* the powers of five of the printer, as truncated and as inverted ones of 125 bits */
+static const int pow5_bits = 125;
+static const int pow5_size = 326;
+static const int pow5_inverse_size = 342;
+
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+// Significand and decimal exponent of a literal, with the digits beyond the first 19 dropped.
+struct LispDecimal {
+    uint64_t significand;
+    int exponent;
+    bool is_negative;
+    bool is_truncated;
+};
+
+inline bool scan_decimal(const std::string& text, LispDecimal& decimal);
+inline bool parse_fast(const LispDecimal& decimal, double& value);
+inline bool parse_eisel_lemire(uint64_t significand, int exponent, double& value);
+inline void shortest_decimal(uint64_t mantissa, int exponent, uint64_t& digits, int& decimal_exponent);
+inline uint64_t multiply_shift(uint64_t m, uint128 factor, int shift);
+inline int pow5_factor(uint64_t value);
+inline int pow5_bit_length(int exponent);
+inline int log10_pow2(int exponent);
+inline int log10_pow5(int exponent);
+inline int bit_length(const LispBigInteger& value);
+inline uint128 truncate_to_bits(const LispBigInteger& value, int bits);
+inline uint128 to_uint128(const LispBigInteger& value);
+inline const std::vector<uint128>& powers_of_five_128();
+inline const std::vector<uint128>& pow5_split();
+inline const std::vector<uint128>& pow5_inverse_split();
+
+
+bool parse_floating(const std::string& text, double& value) {
+    LispDecimal decimal;
+    if (!scan_decimal(text, decimal)) return false;
+    if (decimal.is_truncated || !parse_fast(decimal, value)) {
+        /* long significands, subnormals and the odd ambiguous product are rounded by the library */
+        value = std::strtod(text.c_str(), nullptr);
+    }
+    return true;
+}
+
+std::string format_floating(double value) {
+    if (std::isnan(value)) return "nan";
+    if (std::isinf(value)) return value < 0 ? "-inf" : "inf";
+
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    char buffer[32];
+    char* cursor = buffer;
+    if (bits >> 63) *cursor++ = '-';
+    if (value == 0) return std::string(buffer, cursor) + "0.0";
+
+    uint64_t digits;
+    int exponent;
+    shortest_decimal(bits & ((uint64_t(1) << mantissa_bits) - 1),
+        static_cast<int>((bits >> mantissa_bits) & 0x7ff), digits, exponent);
+    char significand[20];
+    int length = 0;
+    for (; digits; digits /= 10) significand[19 - length++] = static_cast<char>('0' + digits % 10);
+    const char* first = significand + 20 - length;
+    const int scientific_exponent = length - 1 + exponent;
+
+    if (scientific_exponent < -5 || scientific_exponent >= 16) {
+        *cursor++ = first[0];
+        if (length > 1) {
+            *cursor++ = '.';
+            cursor = std::copy(first + 1, first + length, cursor);
+        }
+        *cursor++ = 'e';
+        return std::string(buffer, cursor) + std::to_string(scientific_exponent);
+    }
+
+    const int point = length + exponent;
+    if (point <= 0) {
+        *cursor++ = '0';
+        *cursor++ = '.';
+        cursor = std::fill_n(cursor, -point, '0');
+        cursor = std::copy(first, first + length, cursor);
+    } else if (exponent >= 0) {
+        cursor = std::copy(first, first + length, cursor);
+        cursor = std::fill_n(cursor, exponent, '0');
+        *cursor++ = '.';
+        *cursor++ = '0';
+    } else {
+        cursor = std::copy(first, first + point, cursor);
+        *cursor++ = '.';
+        cursor = std::copy(first + point, first + length, cursor);
+    }
+    return std::string(buffer, cursor);
+}
+
+
+// Splits [sign]digits[.[digits]][(e|E)[sign]digits] into its significand and exponent.
+inline bool scan_decimal(const std::string& text, LispDecimal& decimal) {
+    const char* cursor = text.c_str();
+    const char* end = cursor + text.length();
+    decimal.significand = 0;
+    decimal.exponent = 0;
+    decimal.is_negative = *cursor == '-';
+    decimal.is_truncated = false;
+    if (*cursor == '-' || *cursor == '+') cursor++;
+
+    int digits = 0;
+    bool is_fraction = false;
+    const char* digits_begin = cursor;
+    for (; cursor != end; cursor++) {
+        if (*cursor == '.' && !is_fraction) {
+            is_fraction = true;
+            continue;
+        }
+        if (*cursor < '0' || *cursor > '9') break;
+
+        if (decimal.significand == 0 && *cursor == '0') {
+            if (is_fraction) decimal.exponent--;
+        } else if (digits < significant_digits) {
+            decimal.significand = decimal.significand * 10 + (*cursor - '0');
+            digits++;
+            if (is_fraction) decimal.exponent--;
+        } else {
+            decimal.is_truncated = true;
+            if (!is_fraction) decimal.exponent++;
+        }
+    }
+    if (cursor == digits_begin || *digits_begin == '.') return false;
+
+    if (cursor != end && (*cursor == 'e' || *cursor == 'E')) {
+        cursor++;
+        const bool is_negative_exponent = *cursor == '-';
+        if (*cursor == '-' || *cursor == '+') cursor++;
+        if (cursor == end) return false;
+
+        /* exponents past any double are clamped, which still reads them as zero or infinity */
+        int exponent = 0;
+        for (; cursor != end && *cursor >= '0' && *cursor <= '9'; cursor++) {
+            if (exponent < 100000) exponent = exponent * 10 + (*cursor - '0');
+        }
+        decimal.exponent += is_negative_exponent ? -exponent : exponent;
+    } else if (!is_fraction) {
+        return false;
+    }
+    return cursor == end;
+}
+
+// Rounds exactly representable significands by one operation, then the rest by Eisel and Lemire.
+inline bool parse_fast(const LispDecimal& decimal, double& value) {
+    const uint64_t significand = decimal.significand;
+    const int exponent = decimal.exponent;
+    if (significand == 0 || exponent < smallest_power_of_ten) {
+        value = 0;
+    } else if (exponent > largest_power_of_ten) {
+        value = HUGE_VAL;
+    } else if (significand <= uint64_t(1) << (mantissa_bits + 1) && exponent >= -22 && exponent <= 22) {
+        value = static_cast<double>(significand);
+        value = exponent < 0 ? value / exact_powers_of_ten[-exponent] : value * exact_powers_of_ten[exponent];
+    } else if (!parse_eisel_lemire(significand, exponent, value)) {
+        return false;
+    }
+    if (decimal.is_negative) value = -value;
+    return true;
+}
+
+// The significand times a 128-bit power of five, whose top 55 bits or so decide the rounding.
+// False when the truncated power leaves the result ambiguous, or on subnormal results.
+inline bool parse_eisel_lemire(uint64_t significand, int exponent, double& value) {
+    const int leading_zeros = __builtin_clzll(significand);
+    significand <<= leading_zeros;
+
+    const uint128 power = powers_of_five_128()[exponent - smallest_power_of_ten];
+    const uint128 first = static_cast<uint128>(significand) * static_cast<uint64_t>(power >> 64);
+    uint64_t upper = static_cast<uint64_t>(first >> 64), lower = static_cast<uint64_t>(first);
+    const uint64_t precision_mask = UINT64_MAX >> (mantissa_bits + 3);
+    if ((upper & precision_mask) == precision_mask) {
+        const uint128 second = static_cast<uint128>(significand) * static_cast<uint64_t>(power);
+        const uint64_t second_upper = static_cast<uint64_t>(second >> 64);
+        lower += second_upper;
+        if (second_upper > lower) upper++;
+    }
+    if (lower == UINT64_MAX && (exponent < -27 || exponent > 55)) return false;
+
+    const int upper_bit = static_cast<int>(upper >> 63);
+    const int shift = upper_bit + 64 - mantissa_bits - 3;
+    uint64_t mantissa = upper >> shift;
+    int binary_exponent = (((152170 + 65536) * exponent) >> 16) + 63 + upper_bit - leading_zeros + exponent_bias;
+    if (binary_exponent <= 0) return false;
+
+    /* halfway between two doubles, where only exact products may round to even */
+    if (lower <= 1 && exponent >= -4 && exponent <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == upper) {
+        mantissa &= ~uint64_t(1);
+    }
+    mantissa = (mantissa + (mantissa & 1)) >> 1;
+    if (mantissa >= uint64_t(2) << mantissa_bits) {
+        mantissa = uint64_t(1) << mantissa_bits;
+        binary_exponent++;
+    }
+    if (binary_exponent >= 0x7ff) {
+        value = HUGE_VAL;
+        return true;
+    }
+
+    const uint64_t bits = (mantissa & ~(uint64_t(1) << mantissa_bits))
+        | (static_cast<uint64_t>(binary_exponent) << mantissa_bits);
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+// Ryu: the fewest digits inside the interval of decimals that round to the double, nearest to it.
+inline void shortest_decimal(uint64_t mantissa, int exponent, uint64_t& digits, int& decimal_exponent) {
+    int e2;
+    uint64_t m2;
+    if (exponent == 0) {
+        e2 = 1 - exponent_bias - mantissa_bits - 2;
+        m2 = mantissa;
+    } else {
+        e2 = exponent - exponent_bias - mantissa_bits - 2;
+        m2 = (uint64_t(1) << mantissa_bits) | mantissa;
+    }
+    const bool accepts_bounds = (m2 & 1) == 0;
+
+    /* the double and its neighbours halfway down and up, times four */
+    const uint64_t mv = 4 * m2;
+    const uint64_t mm_shift = mantissa != 0 || exponent <= 1;
+    uint64_t vr, vp, vm;
+    int e10;
+    bool vm_is_trailing_zeros = false, vr_is_trailing_zeros = false;
+    if (e2 >= 0) {
+        const int q = log10_pow2(e2) - (e2 > 3);
+        e10 = q;
+        const int shift = -e2 + q + pow5_bits + pow5_bit_length(q) - 1;
+        const uint128 factor = pow5_inverse_split()[q];
+        vr = multiply_shift(4 * m2, factor, shift);
+        vp = multiply_shift(4 * m2 + 2, factor, shift);
+        vm = multiply_shift(4 * m2 - 1 - mm_shift, factor, shift);
+        if (q <= 21) {
+            if (mv % 5 == 0) vr_is_trailing_zeros = pow5_factor(mv) >= q;
+            else if (accepts_bounds) vm_is_trailing_zeros = pow5_factor(mv - 1 - mm_shift) >= q;
+            else vp -= pow5_factor(mv + 2) >= q;
+        }
+    } else {
+        const int q = log10_pow5(-e2) - (-e2 > 1);
+        e10 = q + e2;
+        const int i = -e2 - q;
+        const int shift = q - (pow5_bit_length(i) - pow5_bits);
+        const uint128 factor = pow5_split()[i];
+        vr = multiply_shift(4 * m2, factor, shift);
+        vp = multiply_shift(4 * m2 + 2, factor, shift);
+        vm = multiply_shift(4 * m2 - 1 - mm_shift, factor, shift);
+        if (q <= 1) {
+            vr_is_trailing_zeros = true;
+            if (accepts_bounds) vm_is_trailing_zeros = mm_shift == 1;
+            else vp--;
+        } else if (q < 63) {
+            vr_is_trailing_zeros = (mv & ((uint64_t(1) << q) - 1)) == 0;
+        }
+    }
+
+    /* drops digits while the interval still holds a shorter decimal */
+    int removed = 0;
+    uint64_t output;
+    if (vm_is_trailing_zeros || vr_is_trailing_zeros) {
+        int last_removed_digit = 0;
+        for (; vp / 10 > vm / 10; removed++) {
+            vm_is_trailing_zeros &= vm % 10 == 0;
+            vr_is_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = static_cast<int>(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+        }
+        if (vm_is_trailing_zeros) {
+            for (; vm % 10 == 0; removed++) {
+                vr_is_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = static_cast<int>(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+            }
+        }
+        if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) last_removed_digit = 4;
+        output = vr + ((vr == vm && (!accepts_bounds || !vm_is_trailing_zeros)) || last_removed_digit >= 5);
+    } else {
+        bool rounds_up = false;
+        if (vp / 100 > vm / 100) {
+            rounds_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        for (; vp / 10 > vm / 10; removed++) {
+            rounds_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+        }
+        output = vr + (vr == vm || rounds_up);
+    }
+    digits = output;
+    decimal_exponent = e10 + removed;
+}
+
+// The 64-bit m times a 125-bit factor, shifted right by at least 64.
+inline uint64_t multiply_shift(uint64_t m, uint128 factor, int shift) {
+    const uint128 low = static_cast<uint128>(m) * static_cast<uint64_t>(factor);
+    const uint128 high = static_cast<uint128>(m) * static_cast<uint64_t>(factor >> 64);
+    return static_cast<uint64_t>(((low >> 64) + high) >> (shift - 64));
+}
+
+inline int pow5_factor(uint64_t value) {
+    int count = 0;
+    for (; value % 5 == 0; value /= 5) count++;
+    return count;
+}
+
+/* ceil(log2(5^e)), floor(log10(2^e)) and floor(log10(5^e)) for the exponents of doubles */
+inline int pow5_bit_length(int exponent) {
+    return ((exponent * 1217359) >> 19) + 1;
+}
+
+inline int log10_pow2(int exponent) {
+    return (exponent * 78913) >> 18;
+}
+
+inline int log10_pow5(int exponent) {
+    return (exponent * 732923) >> 20;
+}
+
+inline int bit_length(const LispBigInteger& value) {
+    const std::vector<uint32_t>& magnitude = value.magnitude();
+    return 32 * static_cast<int>(magnitude.size()) - __builtin_clz(magnitude.back());
+}
+
+// The leading bits of a positive value, shifted up or truncated down to exactly that many.
+inline uint128 truncate_to_bits(const LispBigInteger& value, int bits) {
+    const int excess = bit_length(value) - bits;
+    const LispBigInteger two(2);
+    return to_uint128(excess > 0 ? value / two.pow(excess) : value * two.pow(-excess));
+}
+
+// A value below 2^128.
+inline uint128 to_uint128(const LispBigInteger& value) {
+    uint128 result = 0;
+    const std::vector<uint32_t>& magnitude = value.magnitude();
+    for (size_t index = magnitude.size(); index > 0; index--) result = (result << 32) | magnitude[index - 1];
+    return result;
+}
+
+/* the tables are derived once from exact powers rather than spelled out as thousands of literals */
+
+// 5^q for q in [-342, 308], normalized to 128 bits, with negative powers rounded up.
+inline const std::vector<uint128>& powers_of_five_128() {
+    static const std::vector<uint128> powers = [] {
+        std::vector<uint128> result;
+        const LispBigInteger two(2), five(5);
+        for (int exponent = smallest_power_of_ten; exponent <= largest_power_of_ten; exponent++) {
+            if (exponent >= 0) {
+                result.push_back(truncate_to_bits(five.pow(exponent), 128));
+                continue;
+            }
+            const LispBigInteger power = five.pow(-exponent);
+            const int bits = bit_length(power);
+            const int scale = exponent >= -27 ? bits + 127 : 2 * bits + 128;
+            result.push_back(truncate_to_bits(two.pow(scale) / power + LispBigInteger(1), 128));
+        }
+        return result;
+    }();
+    return powers;
+}
+
+// 5^i truncated to 125 bits.
+inline const std::vector<uint128>& pow5_split() {
+    static const std::vector<uint128> powers = [] {
+        std::vector<uint128> result;
+        LispBigInteger power(1);
+        for (int exponent = 0; exponent < pow5_size; exponent++, power = power * LispBigInteger(5)) {
+            result.push_back(truncate_to_bits(power, pow5_bits));
+        }
+        return result;
+    }();
+    return powers;
+}
+
+// 2^(bits of 5^i - 1 + 125) / 5^i, rounded up.
+inline const std::vector<uint128>& pow5_inverse_split() {
+    static const std::vector<uint128> powers = [] {
+        std::vector<uint128> result;
+        const LispBigInteger two(2);
+        LispBigInteger power(1);
+        for (int exponent = 0; exponent < pow5_inverse_size; exponent++, power = power * LispBigInteger(5)) {
+            result.push_back(to_uint128(two.pow(bit_length(power) - 1 + pow5_bits) / power + LispBigInteger(1)));
+        }
+        return result;
+    }();
+    return powers;
+}
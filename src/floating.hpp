@@ -0,0 +1,16 @@
+#ifndef _FLOATING_HPP_
+#define _FLOATING_HPP_
+
+
+#include <string>
+
+
+// Reads a decimal number with a fraction, an exponent or both, such as 1.5, -2e10 or 3.25E-4,
+// rounded to the nearest double; false if text is not such a number.
+bool parse_floating(const std::string& text, double& value);
+
+// Fewest decimal digits that read back as value, with a point or an exponent, so that they
+// read back as a floating-point number rather than an integer.
+std::string format_floating(double value);
+
+#endif  // _FLOATING_HPP_
@@ -0,0 +1,156 @@
+#include "gc.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+#include "lispvalue.hpp"
+#include "memo.hpp"
+
+
+static const size_t minimum_threshold = 4096;
+
+
+LispCollector::LispCollector():
+_first_tracked(),
+_tracked_count(),
+_tracked_after_collection(),
+_collection_count(),
+_reclaimed_count(),
+_roots(),
+_tracked_mutex()
+{}
+
+void LispCollector::track(LispEnvironment* environment) {
+    if (LispThreadPool::is_in_task()) return;
+    /* other isolates may be running tasks meanwhile, which untrack environments of their own */
+    std::unique_lock<std::mutex> lock(_tracked_mutex, std::defer_lock);
+    if (LispThreadPool::is_parallel()) lock.lock();
+    environment->_tracked = true;
+    environment->_next_tracked = _first_tracked;
+    if (_first_tracked) _first_tracked->_previous_tracked = environment;
+    _first_tracked = environment;
+    _tracked_count++;
+}
+
+void LispCollector::untrack(LispEnvironment* environment) {
+    if (!environment->_tracked) return;
+    /* environments tracked before parallel tasks started may be released by any of them */
+    std::unique_lock<std::mutex> lock(_tracked_mutex, std::defer_lock);
+    if (LispThreadPool::is_parallel()) lock.lock();
+    if (environment->_previous_tracked) {
+        environment->_previous_tracked->_next_tracked = environment->_next_tracked;
+    } else {
+        _first_tracked = environment->_next_tracked;
+    }
+    if (environment->_next_tracked) {
+        environment->_next_tracked->_previous_tracked = environment->_previous_tracked;
+    }
+    _tracked_count--;
+}
+
+void LispCollector::add_root(const LispEnvironment* environment) {
+    _roots.push_back(environment);
+}
+
+void LispCollector::remove_root(const LispEnvironment* environment) {
+    _roots.erase(std::remove(_roots.begin(), _roots.end(), environment), _roots.end());
+}
+
+void LispCollector::collect() {
+    _collection_count++;
+
+    /* mark: environments and values reachable from the roots, without recursion */
+    std::vector<const LispEnvironment*> environments(_roots);
+    std::vector<const LispValue*> values;
+    std::unordered_set<const LispObject*> visited;
+    std::vector<LispEnvironment*> untracked;
+    while (!environments.empty() || !values.empty()) {
+        if (!environments.empty()) {
+            LispEnvironment* environment = const_cast<LispEnvironment*>(environments.back());
+            environments.pop_back();
+            for (; environment && !environment->_marked; environment = environment->_parent_environment.get()) {
+                environment->_marked = true;
+                if (!environment->_tracked) untracked.push_back(environment);
+                for (const auto& entry : environment->_envmap) values.push_back(&entry.second.value);
+                for (const LispValue& slot : environment->_slots) values.push_back(&slot);
+            }
+            continue;
+        }
+
+        const LispValue* value = values.back();
+        values.pop_back();
+        switch (value->type) {
+            case LispType::LambdaFunction: {
+                const LispLambdaObject* lambda = static_cast<const LispLambdaObject*>(value->_object);
+                if (!visited.insert(lambda).second) break;
+                environments.push_back(lambda->environment.get());
+                values.push_back(&lambda->params);
+                values.push_back(&lambda->body);
+                for (const LispValue& argument : lambda->bound_arguments) values.push_back(&argument);
+                /* remembered results may be the only way to closures made by the calls */
+                if (lambda->memo) {
+                    for (const LispMemoTable::Entry& entry : lambda->memo->_entries) {
+                        for (const LispValue& argument : entry.arguments) values.push_back(&argument);
+                        values.push_back(&entry.result);
+                    }
+                }
+                break;
+            }
+            case LispType::S_Expression:
+            case LispType::Q_Expression:
+                /* compiled code only holds cells of its own list, so lists are traced by their cells */
+                for (
+                    const LispListNode* node = static_cast<const LispListNode*>(value->_object);
+                    node && visited.insert(node).second;
+                    node = node->tail
+                ) {
+                    values.push_back(&node->head);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    /* frames of parallel tasks are not swept, but still unmarked for the next collection */
+    for (LispEnvironment* environment : untracked) environment->_marked = false;
+
+    /* sweep: empty every unreachable environment before any of them is freed */
+    std::vector<std::unordered_map<int, LispEnvironment::MapValue>> maps;
+    std::vector<std::vector<LispValue>> slots;
+    std::vector<std::shared_ptr<LispEnvironment>> parents;
+    for (LispEnvironment* environment = _first_tracked; environment; environment = environment->_next_tracked) {
+        if (environment->_marked) {
+            environment->_marked = false;
+            continue;
+        }
+        maps.push_back(std::move(environment->_envmap));
+        environment->_envmap.clear();
+        environment->_version = ++LispEnvironment::_last_version;
+        slots.push_back(std::move(environment->_slots));
+        environment->_slots.clear();
+        parents.push_back(std::move(environment->_parent_environment));
+    }
+
+    const size_t before = _tracked_count;
+    maps.clear();
+    slots.clear();
+    parents.clear();
+    _reclaimed_count += before - _tracked_count;
+    _tracked_after_collection = _tracked_count;
+}
+
+void LispCollector::collect_if_needed() {
+    if (_tracked_count >= std::max(minimum_threshold, 2 * _tracked_after_collection)) collect();
+}
+
+size_t LispCollector::collections() const {
+    return _collection_count;
+}
+
+size_t LispCollector::tracked() const {
+    return _tracked_count;
+}
+
+size_t LispCollector::reclaimed() const {
+    return _reclaimed_count;
+}
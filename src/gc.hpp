@@ -0,0 +1,54 @@
+#ifndef _GC_HPP_
+#define _GC_HPP_
+
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+
+class LispEnvironment;
+
+// Mark-and-sweep collector for environments kept alive only by reference cycles,
+// such as a global environment and the closures defined in it.
+// Every environment is tracked from construction to destruction by the collector of its
+// global environment, so that each isolate collects its own. A collection marks
+// everything reachable from the roots and breaks the cycles among the rest, after
+// which reference counting frees them.
+// The only roots are global environments: the frames of calls in progress, and the values
+// the evaluator holds on the C++ stack, are not registered. A collection must therefore
+// only run between top-level forms, when the evaluator holds no values of its own, which is
+// where the script and REPL loops call collect_if_needed; it is not reachable from Lisp.
+// Call frames made by parallel tasks are not tracked: frames bind arguments evaluated before
+// they exist, so no cycle runs through them.
+class LispCollector {
+    public:
+        LispCollector();
+        LispCollector(const LispCollector&) = delete;
+        LispCollector& operator=(const LispCollector&) = delete;
+
+        void track(LispEnvironment* environment);
+        void untrack(LispEnvironment* environment);
+
+        void add_root(const LispEnvironment* environment);
+        void remove_root(const LispEnvironment* environment);
+
+        void collect();
+        // collects once the tracked environments have doubled since the last collection
+        void collect_if_needed();
+
+        size_t collections() const;
+        size_t tracked() const;         // environments alive, reachable or not
+        size_t reclaimed() const;       // environments freed by collections so far
+
+    private:
+        LispEnvironment* _first_tracked;
+        size_t _tracked_count;
+        size_t _tracked_after_collection;
+        size_t _collection_count;
+        size_t _reclaimed_count;
+        std::vector<const LispEnvironment*> _roots;
+        std::mutex _tracked_mutex;             // held while tasks may be running
+};
+
+#endif  // _GC_HPP_
@@ -0,0 +1,676 @@
+#include "image.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include "evaluation.hpp"
+#include "mappedfile.hpp"
+#include "memo.hpp"
+
+
+/*
+ * An image holds, in order, the magic, the symbol names, the number of lambda scopes, the
+ * records and the global bindings. Integers are variable-length, seven bits to a byte.
+ * Records make resolved symbols, list cells, lambda functions and call frames, each after
+ * everything it refers to, so that reading needs neither recursion nor fixups. Values refer
+ * to the first three kinds by how many records back they are, and to frames by index from 1,
+ * where frame 0 is the global environment the image is loaded into. Resolved symbols with
+ * the same address are written once and shared when loaded.
+ */
+static const char image_magic[8] = { 'B', 'Y', 'O', 'L', 'I', 'M', 'G', '2' };
+
+enum class LispImageRecord : uint8_t {
+    Symbol,     // symbol, scope, depth, slot
+    Cell,       // head value, tail cell or 0
+    Lambda,     // params, body, frame, scope, bound arguments, memo capacity or 0
+    Frame,      // parent frame, scope, params, slots
+};
+
+
+class LispImageWriter {
+    public:
+        LispImageWriter(const LispEnvironment* global);
+
+        // image of every binding in the global environment that is not reserved
+        std::string write();
+
+    private:
+        struct Pending {
+            LispImageRecord record;
+            const void* object;
+            bool is_expanded;
+        };
+        using LispAddressKey = std::tuple<int, unsigned long, int, int>;
+
+        const LispEnvironment* const _global;
+        std::string _records;
+        uint64_t _record_count;
+        std::unordered_map<const void*, uint64_t> _objects;    // cells and lambda functions
+        std::map<LispAddressKey, uint64_t> _addresses;         // resolved symbols
+        std::unordered_map<const void*, uint64_t> _frames;
+        std::unordered_map<unsigned long, uint64_t> _scopes;
+        std::unordered_map<int, uint64_t> _symbols;
+        std::vector<int> _symbol_ids;
+        std::vector<Pending> _pending;
+
+        void add(const LispValue& value);
+        void schedule(const LispValue& value);
+        void schedule_frame(const LispEnvironment* frame);
+        bool is_written(const Pending& pending) const;
+        void expand(const Pending& pending);
+        void write_record(const Pending& pending);
+        void write_address(const LispValue& symbol);
+        void write_value(std::string& out, const LispValue& value);
+        // distance back to a record from the one being written, so that nearby ones are short
+        uint64_t reference(uint64_t index) const;
+        uint64_t object_reference(const LispObject* object) const;
+        uint64_t frame_index(const LispEnvironment* frame) const;
+        uint64_t scope_index(unsigned long scope);
+        uint64_t symbol_index(int symbol_id);
+};
+
+class LispImageReader {
+    public:
+        LispImageReader(
+            const std::string& path,
+            LispMappedFile* file,
+            const std::shared_ptr<LispEnvironment>& global
+        );
+        ~LispImageReader();
+
+        LispImageReader(const LispImageReader&) = delete;
+        LispImageReader& operator=(const LispImageReader&) = delete;
+
+        void read();
+
+    private:
+        const std::string& _path;
+        LispMappedFile* const _file;
+        const char* _cursor;
+        const char* const _end;
+        const std::shared_ptr<LispEnvironment> _global;
+        std::vector<int> _symbols;
+        std::vector<unsigned long> _scopes;
+        std::vector<LispValue> _objects;
+        std::vector<std::shared_ptr<LispEnvironment>> _frames;
+
+        /* addresses of resolved symbols and lambda functions by scope, checked against each other
+           in whichever order they come, since quoted code may follow the function it was made in */
+        std::unordered_map<unsigned long, std::vector<LispLexicalAddress>> _addresses;
+        std::unordered_map<unsigned long, std::vector<LispValue>> _lambdas;
+
+        uint64_t get();
+        int get_signed() { const uint64_t value = get(); return static_cast<int>((value >> 1) ^ -(value & 1)); }
+        const char* get_bytes(size_t size);
+        size_t get_count();
+        LispValue read_value();
+        LispValue read_value_of(LispType type);
+        const LispValue& object(uint64_t reference, LispType type);
+        const std::shared_ptr<LispEnvironment>& read_frame();
+        int read_symbol();
+        int symbol_at(uint64_t index);
+        unsigned long read_scope();
+        void check_address(const LispLexicalAddress& address, const LispValue& lambda);
+        [[noreturn]] void fail();
+};
+
+
+inline std::shared_ptr<LispEnvironment> global_of(const std::shared_ptr<LispEnvironment>& environment);
+inline void put(std::string& out, uint64_t value);
+inline void put_signed(std::string& out, int value);
+
+
+void save_image(const std::string& path, const std::shared_ptr<LispEnvironment>& environment) {
+    const std::shared_ptr<LispEnvironment> global(global_of(environment));
+    const std::string image(LispImageWriter(global.get()).write());
+
+    std::ofstream output(path, std::ios::binary);
+    if (!output) {
+        throw std::invalid_argument("Error: cannot open file " + path);
+    }
+    output.write(image.data(), image.size());
+    output.close();
+    if (!output) {
+        throw std::invalid_argument("Error: cannot write file " + path);
+    }
+}
+
+void load_image(const std::string& path, const std::shared_ptr<LispEnvironment>& environment) {
+    LispMappedFile* file = LispMappedFile::open(path);
+    if (!file) {
+        throw std::invalid_argument("Error: cannot open file " + path);
+    }
+    LispImageReader reader(path, file, global_of(environment));
+    reader.read();
+}
+
+
+LispImageWriter::LispImageWriter(const LispEnvironment* global):
+_global(global),
+_records(),
+_record_count(),
+_objects(),
+_addresses(),
+_frames(),
+_scopes(),
+_symbols(),
+_symbol_ids(),
+_pending()
+{}
+
+std::string LispImageWriter::write() {
+    std::vector<const std::pair<const int, LispEnvironment::MapValue>*> entries;
+    for (const auto& entry : _global->_envmap) {
+        if (entry.second.is_reserved) continue;
+        add(entry.second.value);
+        entries.push_back(&entry);
+    }
+
+    /* bindings refer back from past the last record */
+    std::string bindings;
+    put(bindings, entries.size());
+    for (const auto* entry : entries) {
+        put(bindings, symbol_index(entry->first));
+        write_value(bindings, entry->second.value);
+    }
+
+    std::string image(image_magic, sizeof(image_magic));
+    put(image, _symbol_ids.size());
+    for (int symbol_id : _symbol_ids) {
+        const std::string& name(LispSymbolTable::name(symbol_id));
+        put(image, name.size());
+        image.append(name);
+    }
+    put(image, _scopes.size());
+    put(image, _record_count);
+    image.append(_records);
+    image.append(bindings);
+    return image;
+}
+
+void LispImageWriter::add(const LispValue& value) {
+    /* records are written in post-order, from a stack rather than by recursion */
+    schedule(value);
+    while (!_pending.empty()) {
+        const Pending pending = _pending.back();
+        if (is_written(pending)) {
+            _pending.pop_back();
+        } else if (!pending.is_expanded) {
+            _pending.back().is_expanded = true;
+            expand(pending);
+        } else {
+            _pending.pop_back();
+            write_record(pending);
+        }
+    }
+}
+
+void LispImageWriter::schedule(const LispValue& value) {
+    switch (value.type) {
+        case LispType::Symbol:
+            /* a resolved symbol refers to nothing, so its record can be written right away */
+            if (value._object) write_address(value);
+            break;
+        case LispType::LambdaFunction:
+            _pending.push_back({ LispImageRecord::Lambda, value._object, false });
+            break;
+        case LispType::S_Expression:
+        case LispType::Q_Expression:
+            if (value._object) _pending.push_back({ LispImageRecord::Cell, value._object, false });
+            break;
+        default:
+            break;
+    }
+}
+
+void LispImageWriter::schedule_frame(const LispEnvironment* frame) {
+    if (frame != _global) _pending.push_back({ LispImageRecord::Frame, frame, false });
+}
+
+bool LispImageWriter::is_written(const Pending& pending) const {
+    if (pending.record == LispImageRecord::Frame) return _frames.count(pending.object) != 0;
+    return _objects.count(pending.object) != 0;
+}
+
+void LispImageWriter::expand(const Pending& pending) {
+    switch (pending.record) {
+        case LispImageRecord::Cell: {
+            const LispListNode* node = static_cast<const LispListNode*>(pending.object);
+            schedule(node->head);
+            if (node->tail) {
+                _pending.push_back({ LispImageRecord::Cell, static_cast<const LispObject*>(node->tail), false });
+            }
+            break;
+        }
+        case LispImageRecord::Lambda: {
+            const LispLambdaObject* lambda = static_cast<const LispLambdaObject*>(pending.object);
+            schedule(lambda->params);
+            schedule(lambda->body);
+            for (const LispValue& argument : lambda->bound_arguments) schedule(argument);
+            schedule_frame(lambda->environment.get());
+            break;
+        }
+        case LispImageRecord::Frame: {
+            const LispEnvironment* frame = static_cast<const LispEnvironment*>(pending.object);
+            schedule(frame->_params);
+            for (const LispValue& slot : frame->_slots) schedule(slot);
+            schedule_frame(frame->_parent_environment.get());
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void LispImageWriter::write_record(const Pending& pending) {
+    _records.push_back(static_cast<char>(pending.record));
+    switch (pending.record) {
+        case LispImageRecord::Cell: {
+            const LispListNode* node = static_cast<const LispListNode*>(pending.object);
+            write_value(_records, node->head);
+            put(_records, node->tail ? object_reference(node->tail) : 0);
+            _objects.emplace(pending.object, ++_record_count);
+            break;
+        }
+        case LispImageRecord::Lambda: {
+            const LispLambdaObject* lambda = static_cast<const LispLambdaObject*>(pending.object);
+            write_value(_records, lambda->params);
+            write_value(_records, lambda->body);
+            put(_records, frame_index(lambda->environment.get()));
+            put(_records, scope_index(lambda->scope));
+            put(_records, lambda->bound_arguments.size());
+            for (const LispValue& argument : lambda->bound_arguments) write_value(_records, argument);
+            /* remembered results are not kept, only that the function remembers them */
+            put(_records, lambda->memo ? lambda->memo->capacity() : 0);
+            _objects.emplace(pending.object, ++_record_count);
+            break;
+        }
+        case LispImageRecord::Frame: {
+            const LispEnvironment* frame = static_cast<const LispEnvironment*>(pending.object);
+            put(_records, frame_index(frame->_parent_environment.get()));
+            put(_records, scope_index(frame->_scope));
+            write_value(_records, frame->_params);
+            put(_records, frame->_slots.size());
+            for (const LispValue& slot : frame->_slots) write_value(_records, slot);
+            _frames.emplace(pending.object, _frames.size() + 1);
+            _record_count++;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void LispImageWriter::write_address(const LispValue& symbol) {
+    const LispLexicalAddress& address(symbol.lexical_address());
+    const LispAddressKey key(symbol.symbol_id(), address.scope, address.depth, address.slot);
+    if (_addresses.count(key)) return;
+
+    _records.push_back(static_cast<char>(LispImageRecord::Symbol));
+    put(_records, symbol_index(symbol.symbol_id()));
+    put(_records, scope_index(address.scope));
+    put_signed(_records, address.depth);
+    put_signed(_records, address.slot);
+    _addresses.emplace(key, ++_record_count);
+}
+
+void LispImageWriter::write_value(std::string& out, const LispValue& value) {
+    out.push_back(static_cast<char>(value.type));
+    switch (value.type) {
+        case LispType::Unit:
+            break;
+        case LispType::Number:
+            put_signed(out, value.number);
+            break;
+        case LispType::String: {
+            const LispStringView string(value.str());
+            put(out, string.size());
+            out.append(string.data(), string.size());
+            break;
+        }
+        case LispType::Symbol:
+            if (value._object) {
+                /* resolved symbols are records, told apart from symbol ids by the low bit */
+                const LispLexicalAddress& address(value.lexical_address());
+                put(out, reference(_addresses.at(LispAddressKey(
+                    value.symbol_id(), address.scope, address.depth, address.slot))) << 1 | 1);
+            } else {
+                put(out, symbol_index(value.symbol_id()) << 1);
+            }
+            break;
+        case LispType::BuiltinFunction:
+            put(out, symbol_index(value.symbol_id()));
+            break;
+        case LispType::LambdaFunction:
+            put(out, object_reference(value._object));
+            break;
+        case LispType::S_Expression:
+        case LispType::Q_Expression:
+            put(out, value._object ? object_reference(value._object) : 0);
+            break;
+        case LispType::Vector: {
+            const LispVectorView numbers(value.numbers());
+            put(out, numbers.size());
+            for (int number : numbers) put_signed(out, number);
+            break;
+        }
+        case LispType::BigInteger: {
+            const LispBigInteger& integer(value.big_integer());
+            put(out, integer.is_negative());
+            put(out, integer.magnitude().size());
+            for (uint32_t limb : integer.magnitude()) put(out, limb);
+            break;
+        }
+        case LispType::Float: {
+            /* the bits as they are, least significant byte first */
+            const double real = value.real();
+            uint64_t bits;
+            std::memcpy(&bits, &real, sizeof(bits));
+            for (int shift = 0; shift < 64; shift += 8) out += static_cast<char>(bits >> shift);
+            break;
+        }
+    }
+}
+
+uint64_t LispImageWriter::reference(uint64_t index) const {
+    return _record_count + 1 - index;
+}
+
+uint64_t LispImageWriter::object_reference(const LispObject* object) const {
+    return reference(_objects.at(object));
+}
+
+uint64_t LispImageWriter::frame_index(const LispEnvironment* frame) const {
+    return frame == _global ? 0 : _frames.at(frame);
+}
+
+uint64_t LispImageWriter::scope_index(unsigned long scope) {
+    if (scope == 0) return 0;
+    return _scopes.emplace(scope, _scopes.size() + 1).first->second;
+}
+
+uint64_t LispImageWriter::symbol_index(int symbol_id) {
+    const auto itr = _symbols.emplace(symbol_id, _symbol_ids.size());
+    if (itr.second) _symbol_ids.push_back(symbol_id);
+    return itr.first->second;
+}
+
+
+LispImageReader::LispImageReader(
+    const std::string& path,
+    LispMappedFile* file,
+    const std::shared_ptr<LispEnvironment>& global
+):
+_path(path),
+_file(file),
+_cursor(file->data),
+_end(file->data + file->size),
+_global(global),
+_symbols(),
+_scopes(1),
+_objects(1),
+_frames(1, global)
+{}
+
+LispImageReader::~LispImageReader() {
+    if (_file->release()) delete _file;
+}
+
+void LispImageReader::read() {
+    if (_end - _cursor < static_cast<ptrdiff_t>(sizeof(image_magic)) ||
+        std::memcmp(_cursor, image_magic, sizeof(image_magic)) != 0) {
+        throw std::invalid_argument("Error: " + _path + " is not an image");
+    }
+    _cursor += sizeof(image_magic);
+
+    for (size_t count = get_count(); count > 0; count--) {
+        const size_t size = get();
+        const char* name = get_bytes(size);
+        _symbols.push_back(LispSymbolTable::intern(std::string(name, size)));
+    }
+
+    /* scopes are renumbered, so that they never collide with those made in this run */
+    for (size_t count = get_count(); count > 0; count--) {
+        _scopes.push_back(new_lambda_scope());
+    }
+
+    const size_t record_count = get_count();
+    _objects.reserve(record_count + 1);
+    for (size_t count = record_count; count > 0; count--) {
+        switch (static_cast<LispImageRecord>(get_bytes(1)[0])) {
+            case LispImageRecord::Symbol: {
+                const int symbol_id = read_symbol();
+                LispLexicalAddress address;
+                address.scope = read_scope();
+                address.depth = get_signed();
+                address.slot = get_signed();
+                if (address.scope == 0) fail();
+                for (const LispValue& lambda : _lambdas[address.scope]) check_address(address, lambda);
+                _addresses[address.scope].push_back(address);
+                _objects.push_back(LispValue(LispType::Symbol, symbol_id, address));
+                break;
+            }
+            case LispImageRecord::Cell: {
+                const LispValue head(read_value());
+                const LispValue tail(read_value_of(LispType::S_Expression));
+                _objects.push_back(LispValue(LispType::S_Expression, head, tail));
+                break;
+            }
+            case LispImageRecord::Lambda: {
+                const LispValue params(read_value());
+                const LispValue body(read_value());
+                const std::shared_ptr<LispEnvironment>& environment(read_frame());
+                const unsigned long scope = read_scope();
+                std::vector<LispValue> bound_arguments(get_count());
+                for (LispValue& argument : bound_arguments) argument = read_value();
+                const uint64_t memo_capacity = get();
+                if (memo_capacity > static_cast<uint64_t>(std::numeric_limits<int>::max())) fail();
+
+                LispValue lambda(LispType::LambdaFunction, params, body, environment, scope);
+                if (!bound_arguments.empty()) lambda = LispValue(LispType::LambdaFunction, lambda, bound_arguments);
+                if (memo_capacity != 0) {
+                    lambda = LispValue(
+                        LispType::LambdaFunction, lambda, std::make_shared<LispMemoTable>(memo_capacity));
+                }
+                for (const LispLexicalAddress& address : _addresses[scope]) check_address(address, lambda);
+                _lambdas[scope].push_back(lambda);
+                _objects.push_back(lambda);
+                break;
+            }
+            case LispImageRecord::Frame: {
+                const std::shared_ptr<LispEnvironment>& parent(read_frame());
+                const unsigned long scope = read_scope();
+                const LispValue params(read_value());
+                std::vector<LispValue> slots(get_count());
+                for (LispValue& slot : slots) slot = read_value();
+
+                _frames.push_back(std::allocate_shared<LispEnvironment>(
+                    LispPoolAllocator<LispEnvironment>(), parent, params, scope, std::move(slots)));
+                _objects.push_back(LispValue());
+                break;
+            }
+            default:
+                fail();
+        }
+    }
+
+    for (size_t count = get_count(); count > 0; count--) {
+        const int symbol_id = read_symbol();
+        _global->define_global(symbol_id, read_value());
+    }
+    if (_cursor != _end) fail();
+}
+
+uint64_t LispImageReader::get() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (_cursor == _end) fail();
+        const uint8_t byte = *_cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    fail();
+}
+
+const char* LispImageReader::get_bytes(size_t size) {
+    if (static_cast<size_t>(_end - _cursor) < size) fail();
+    const char* bytes = _cursor;
+    _cursor += size;
+    return bytes;
+}
+
+size_t LispImageReader::get_count() {
+    /* every counted item takes a byte at least, so a larger count is corrupt, not a huge allocation */
+    const uint64_t count = get();
+    if (count > static_cast<uint64_t>(_end - _cursor)) fail();
+    return count;
+}
+
+LispValue LispImageReader::read_value() {
+    const uint8_t tag = get_bytes(1)[0];
+    if (tag > static_cast<uint8_t>(LispType::Float)) fail();
+
+    const LispType type = static_cast<LispType>(tag);
+    switch (type) {
+        case LispType::Unit:
+            return LispValue();
+        case LispType::Number:
+            return LispValue(LispType::Number, get_signed());
+        case LispType::String: {
+            const size_t size = get();
+            return LispValue(LispType::String, get_bytes(size), size, _file);
+        }
+        case LispType::Symbol: {
+            const uint64_t reference = get();
+            if (reference & 1) return object(reference >> 1, LispType::Symbol);
+            LispValue symbol;
+            symbol.type = LispType::Symbol;
+            symbol.number = symbol_at(reference >> 1);
+            return symbol;
+        }
+        case LispType::BuiltinFunction: {
+            /* built-in functions are the ones of the environment the image is loaded into */
+            const int symbol_id = read_symbol();
+            if (_global->is_reserved(symbol_id)) {
+                const LispValue builtin(_global->resolve(symbol_id));
+                if (builtin.type == LispType::BuiltinFunction) return builtin;
+            }
+            throw std::invalid_argument(
+                "Error: image " + _path + " refers to unknown built-in function " +
+                LispSymbolTable::name(symbol_id));
+        }
+        case LispType::LambdaFunction:
+            return object(get(), LispType::LambdaFunction);
+        case LispType::Vector: {
+            LispPackedNumbers numbers(get_count());
+            for (int& number : numbers) number = get_signed();
+            return LispValue(LispType::Vector, std::move(numbers));
+        }
+        case LispType::BigInteger: {
+            const bool is_negative = get() != 0;
+            std::vector<uint32_t> magnitude(get_count());
+            for (uint32_t& limb : magnitude) {
+                const uint64_t value = get();
+                if (value > std::numeric_limits<uint32_t>::max()) fail();
+                limb = static_cast<uint32_t>(value);
+            }
+            return LispValue(LispType::Number, LispBigInteger(is_negative, std::move(magnitude)));
+        }
+        case LispType::Float: {
+            const char* bytes = get_bytes(8);
+            uint64_t bits = 0;
+            for (int index = 7; index >= 0; index--) bits = bits << 8 | static_cast<uint8_t>(bytes[index]);
+            double real;
+            std::memcpy(&real, &bits, sizeof(real));
+            return LispValue(LispType::Float, real);
+        }
+        default: {
+            LispValue list(read_value_of(LispType::S_Expression));
+            list.type = type;
+            return list;
+        }
+    }
+}
+
+LispValue LispImageReader::read_value_of(LispType type) {
+    /* reference 0 stands for the empty list */
+    const uint64_t reference = get();
+    return reference ? object(reference, type) : LispValue();
+}
+
+const LispValue& LispImageReader::object(uint64_t reference, LispType type) {
+    if (reference == 0 || reference > _objects.size() - 1) fail();
+    const LispValue& value(_objects[_objects.size() - reference]);
+    if (value.type != type) fail();
+    return value;
+}
+
+const std::shared_ptr<LispEnvironment>& LispImageReader::read_frame() {
+    const uint64_t index = get();
+    if (index >= _frames.size()) fail();
+    return _frames[index];
+}
+
+int LispImageReader::read_symbol() {
+    return symbol_at(get());
+}
+
+int LispImageReader::symbol_at(uint64_t index) {
+    if (index >= _symbols.size()) fail();
+    return _symbols[index];
+}
+
+// Fails unless the address of a symbol in the body of lambda stays within the frames its calls
+// resolve it in: the call frame, which has a slot per parameter, and the frames above it.
+void LispImageReader::check_address(const LispLexicalAddress& address, const LispValue& lambda) {
+    if (address.depth == -1) {
+        if (address.slot != 0) fail();
+        return;
+    }
+    if (address.depth < 0 || address.slot < 0) fail();
+    const size_t slot = static_cast<size_t>(address.slot);
+    if (address.depth == 0) {
+        if (slot >= lambda.params().cells().size()) fail();
+        return;
+    }
+    const LispEnvironment* frame = lambda.local_environment().get();
+    for (int depth = address.depth; depth > 1; depth--) {
+        frame = frame->_parent_environment.get();
+        if (!frame) fail();
+    }
+    if (slot >= frame->_slots.size()) fail();
+}
+
+unsigned long LispImageReader::read_scope() {
+    const uint64_t index = get();
+    if (index >= _scopes.size()) fail();
+    return index == 0 ? 0 : _scopes[index];
+}
+
+void LispImageReader::fail() {
+    throw std::invalid_argument("Error: image " + _path + " is corrupt");
+}
+
+
+inline std::shared_ptr<LispEnvironment> global_of(const std::shared_ptr<LispEnvironment>& environment) {
+    std::shared_ptr<LispEnvironment> global(environment);
+    while (global->parent_environment()) global = global->parent_environment();
+    return global;
+}
+
+inline void put(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline void put_signed(std::string& out, int value) {
+    /* zigzag, so that small negative numbers stay short */
+    put(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(value) >> 63));
+}
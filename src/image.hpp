@@ -0,0 +1,19 @@
+#ifndef _IMAGE_HPP_
+#define _IMAGE_HPP_
+
+
+#include <string>
+#include "lispvalue.hpp"
+
+
+// Writes every definition made in the global environment of environment to an image file,
+// together with the closures, call frames and expressions they hold. Built-in functions
+// are written by name.
+void save_image(const std::string& path, const std::shared_ptr<LispEnvironment>& environment);
+
+// Defines everything saved in the image at path in the global environment of environment,
+// without parsing or evaluating any code. The image is read in place from a memory mapping,
+// and its strings borrow the mapped bytes.
+void load_image(const std::string& path, const std::shared_ptr<LispEnvironment>& environment);
+
+#endif  // _IMAGE_HPP_
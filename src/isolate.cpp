@@ -0,0 +1,57 @@
+#include "isolate.hpp"
+
+#include <fstream>
+#include <iostream>
+#include "builtin.hpp"
+#include "evaluation.hpp"
+#include "mappedfile.hpp"
+#include "script.hpp"
+
+
+LispIsolate::LispIsolate(std::ostream& output, std::ostream& errors):
+_collector(),
+_environment(global_environment(_collector, output, errors)),
+_has_exited(),
+_exit_status()
+{
+    _collector.add_root(_environment.get());
+}
+
+LispIsolate::~LispIsolate() {
+    /* closures defined globally keep the global environment alive, until a collection */
+    _collector.remove_root(_environment.get());
+    _environment.reset();
+    _collector.collect();
+}
+
+size_t LispIsolate::run(LispReader& reader) {
+    if (_has_exited) return 0;
+    try {
+        return run_script(reader, _environment);
+    } catch (const LispExit& exit) {
+        _has_exited = true;
+        _exit_status = exit.status;
+        return 0;
+    }
+}
+
+size_t LispIsolate::run_file(const std::string& path) {
+    if (path == "-") {
+        LispReader reader(std::cin);
+        return run(reader);
+    }
+
+    /* regular files are read in place from a memory mapping */
+    LispMappedFile* file = LispMappedFile::open(path);
+    if (file) {
+        LispReader reader(file);
+        return run(reader);
+    }
+    std::ifstream input(path);
+    if (!input) {
+        _environment->errors() << "Error: cannot open file " << path << std::endl;
+        return 1;
+    }
+    LispReader reader(input);
+    return run(reader);
+}
@@ -0,0 +1,46 @@
+#ifndef _ISOLATE_HPP_
+#define _ISOLATE_HPP_
+
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include "gc.hpp"
+#include "lispvalue.hpp"
+#include "parser.hpp"
+
+
+// Interpreter with a global environment, a collector and output sinks of its own, so that
+// one process can run isolates on separate threads at the same time without locking each
+// other out. An isolate runs on one thread at a time and takes its objects from the pool of
+// that thread. Isolates share only interned symbols and built-in functions, which take a lock
+// when they are added rather than when they are used.
+class LispIsolate {
+    public:
+        LispIsolate(std::ostream& output, std::ostream& errors);
+        ~LispIsolate();
+
+        LispIsolate(const LispIsolate&) = delete;
+        LispIsolate& operator=(const LispIsolate&) = delete;
+
+        const std::shared_ptr<LispEnvironment>& environment() const { return _environment; }
+
+        // Evaluates every form of reader like run_script and returns the number of forms that
+        // failed. Nothing is evaluated any more once exit has been called.
+        size_t run(LispReader& reader);
+
+        // Same for the script at path, or standard input for "-".
+        size_t run_file(const std::string& path);
+
+        bool has_exited() const { return _has_exited; }
+        int exit_status() const { return _exit_status; }
+
+    private:
+        /* declared first, so that it outlives every environment it tracks */
+        LispCollector _collector;
+        std::shared_ptr<LispEnvironment> _environment;
+        bool _has_exited;
+        int _exit_status;
+};
+
+#endif  // _ISOLATE_HPP_
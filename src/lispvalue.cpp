@@ -2,54 +2,342 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "floating.hpp"
 
 
-template<typename T>
-std::ostream& operator<<(std::ostream& os, const std::vector<T>& vector);
+std::ostream& operator<<(std::ostream& os, const LispCells& cells);
+std::ostream& operator<<(std::ostream& os, const LispVectorView& numbers);
+inline size_t hash_bytes(const void* data, size_t size);
+
+
+// List being printed, with the cell to print next and its closing bracket, if any.
+struct LispPrintFrame {
+    LispValue list;
+    LispCells::iterator next;
+    char rparen;
+};
+
+
+std::atomic<unsigned long> LispEnvironment::_last_version(0);
+
+LispValue::LispValue(LispType _type, const std::string& value):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::String && type != LispType::Symbol) {
+        throw std::invalid_argument("Error: type is neither string nor symbol");
+    }
+    if (type == LispType::String) _object = new LispStringObject(value);
+    else                          number = LispSymbolTable::intern(value);
+}
+
+LispValue::LispValue(LispType _type, const char* data, size_t length, LispObject* owner):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::String) {
+        throw std::invalid_argument("Error: type is not string");
+    }
+    _object = new LispStringObject(data, length, owner);
+}
+
+LispValue::LispValue(LispType _type, int symbol_id, const LispLexicalAddress& address):
+type(_type),
+number(symbol_id),
+_object()
+{
+    if (type != LispType::Symbol) {
+        throw std::invalid_argument("Error: type is not symbol");
+    }
+    _object = new LispSymbolObject(address);
+}
+
+LispValue::LispValue(LispType _type, LispBuiltinFunction value, const std::string& _symbol):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::BuiltinFunction) {
+        throw std::invalid_argument("Error: type is not built-in function");
+    }
+    number = LispSymbolTable::intern(_symbol);
+    LispBuiltinTable::add(number, value);
+}
+
+LispValue::LispValue(
+    LispType _type,
+    const LispValue& params,
+    const LispValue& body,
+    const std::shared_ptr<LispEnvironment>& environment,
+    unsigned long scope
+):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::LambdaFunction) {
+        throw std::invalid_argument("Error: type is not lambda function");
+    }
+    _object = new LispLambdaObject(
+        params, body, environment, std::vector<LispValue>(), scope, std::shared_ptr<LispMemoTable>());
+}
+
+LispValue::LispValue(
+    LispType _type,
+    const LispValue& lambda_function,
+    const std::vector<LispValue>& bound_arguments
+):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::LambdaFunction || lambda_function.type != LispType::LambdaFunction) {
+        throw std::invalid_argument("Error: type is not lambda function");
+    }
+    _object = new LispLambdaObject(
+        lambda_function.params(),
+        lambda_function.body(),
+        lambda_function.local_environment(),
+        bound_arguments,
+        lambda_function.scope(),
+        lambda_function.memo()
+    );
+}
+
+LispValue::LispValue(
+    LispType _type,
+    const LispValue& lambda_function,
+    const std::shared_ptr<LispMemoTable>& memo
+):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::LambdaFunction || lambda_function.type != LispType::LambdaFunction) {
+        throw std::invalid_argument("Error: type is not lambda function");
+    }
+    _object = new LispLambdaObject(
+        lambda_function.params(),
+        lambda_function.body(),
+        lambda_function.local_environment(),
+        lambda_function.bound_arguments(),
+        lambda_function.scope(),
+        memo
+    );
+}
+
+LispValue::LispValue(LispType _type, const std::vector<LispValue>& value):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::S_Expression && type != LispType::Q_Expression) {
+        throw std::invalid_argument("Error: type is not expression");
+    }
+    LispListNode* node = nullptr;
+    for (std::vector<LispValue>::const_reverse_iterator itr = value.rbegin(); itr != value.rend(); itr++) {
+        LispListNode* cons = new LispListNode(*itr, node);
+        if (node) node->release();
+        node = cons;
+    }
+    _object = node;
+}
+
+LispValue::LispValue(LispType _type, const LispValue& head, const LispValue& tail):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::S_Expression && type != LispType::Q_Expression) {
+        throw std::invalid_argument("Error: type is not expression");
+    }
+    _object = new LispListNode(head, static_cast<LispListNode*>(tail._object));
+}
+
+LispValue::LispValue(LispType _type, LispPackedNumbers&& numbers):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::Vector) {
+        throw std::invalid_argument("Error: type is not vector");
+    }
+    _object = new LispVectorObject(std::move(numbers));
+}
+
+LispValue::LispValue(LispType _type, LispBigInteger&& value):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::Number) {
+        throw std::invalid_argument("Error: type is not number");
+    }
+    if (value.fits_int()) {
+        number = value.to_int();
+    } else {
+        type = LispType::BigInteger;
+        _object = new LispBigIntegerObject(std::move(value));
+    }
+}
+
+LispValue::LispValue(LispType _type, double value):
+type(_type),
+number(),
+_object()
+{
+    if (type != LispType::Float) {
+        throw std::invalid_argument("Error: type is not float");
+    }
+    _object = new LispFloatObject(value);
+}
+
+LispValue LispValue::drop(size_t n) const {
+    LispValue result(*this);
+    LispListNode* node = static_cast<LispListNode*>(_object);
+    while (n-- && node) node = node->tail;
+    if (node) node->retain();
+    result._release();
+    result._object = node;
+    return result;
+}
 
 
 std::ostream& operator<<(std::ostream& os, const LispValue& value) {
-    switch (value.type) {
-        case LispType::Unit:
-            return os << "()";
-        case LispType::Number:
-            return os << value.number;
-        case LispType::String:
-            return os << '\"' << value.str << '\"';
-        case LispType::Symbol:
-            return os << value.symbol;
-        case LispType::BuiltinFunction:
-            return os << "<built-in> " << value.symbol;
-        case LispType::LambdaFunction:
-            return os << "lambda " << value.cells[0] << ' ' << value.cells[1];
-        case LispType::S_Expression:
-            return os << '(' << value.cells << ')';
-        case LispType::Q_Expression:
-            return os << '{' << value.cells << '}';
-        default:
-            return os;
+    /* lists being printed, innermost last, so that deeply nested ones do not overflow the stack */
+    std::vector<LispPrintFrame> frames;
+    const LispValue* next = &value;
+    while (true) {
+        switch (next->type) {
+            case LispType::Unit:
+                os << "()";
+                break;
+            case LispType::Number:
+                os << next->number;
+                break;
+            case LispType::String:
+                os << '\"' << next->str() << '\"';
+                break;
+            case LispType::Symbol:
+                os << next->symbol();
+                break;
+            case LispType::BuiltinFunction:
+                os << "<built-in> " << next->symbol();
+                break;
+            case LispType::LambdaFunction: {
+                /* the unbound parameters and the body, printed like the cells of a bare list */
+                os << "lambda ";
+                const LispValue parts(LispType::S_Expression, std::vector<LispValue>{
+                    next->params().drop(next->bound_arguments().size()), next->body()
+                });
+                frames.push_back(LispPrintFrame{ parts, parts.cells().begin(), '\0' });
+                break;
+            }
+            case LispType::S_Expression:
+                os << '(';
+                frames.push_back(LispPrintFrame{ *next, next->cells().begin(), ')' });
+                break;
+            case LispType::Q_Expression:
+                os << '{';
+                frames.push_back(LispPrintFrame{ *next, next->cells().begin(), '}' });
+                break;
+            case LispType::Vector:
+                os << '[' << next->numbers() << ']';
+                break;
+            case LispType::BigInteger:
+                os << next->big_integer().to_string();
+                break;
+            case LispType::Float:
+                os << format_floating(next->real());
+                break;
+            default:
+                break;
+        }
+
+        /* lists whose cells are all printed are closed */
+        while (!frames.empty() && frames.back().next == LispCells::iterator(nullptr)) {
+            if (frames.back().rparen) os << frames.back().rparen;
+            frames.pop_back();
+        }
+        if (frames.empty()) return os;
+        LispPrintFrame& frame(frames.back());
+        if (frame.next != frame.list.cells().begin()) os << ' ';
+        next = &*frame.next;
+        ++frame.next;
     }
 }
 
 bool operator ==(const LispValue & x, const LispValue& y) {
+    /* numbers and symbols, the most compared, are told apart by their ids alone */
     if (x.type != y.type) return false;
-    switch (x.type) {
-        case LispType::Unit:
-            return true;
-        case LispType::Number:
-            return x.number == y.number;
-        case LispType::String:
-            return x.str == y.str;
-        case LispType::Symbol:
-        case LispType::BuiltinFunction:
-            return x.symbol == y.symbol;
-        case LispType::LambdaFunction:
-            return x.cells == y.cells && x.local_environment == y.local_environment;
-        case LispType::S_Expression:
-        case LispType::Q_Expression:
-            return x.cells == y.cells;
-        default:
-            throw std::invalid_argument("Error: Unknown type");
+    if (x.type == LispType::Number || x.type == LispType::Symbol || x.type == LispType::BuiltinFunction) {
+        return x.number == y.number;
+    }
+
+    /* pairs of cells left to compare, so that deeply nested lists do not overflow the stack */
+    std::vector<std::pair<const LispValue*, const LispValue*>> pending;
+    std::pair<const LispValue*, const LispValue*> next(&x, &y);
+    while (true) {
+        const LispValue& x_value(*next.first);
+        const LispValue& y_value(*next.second);
+        if (x_value.type != y_value.type) return false;
+        switch (x_value.type) {
+            case LispType::Unit:
+                break;
+            case LispType::Number:
+                if (x_value.number != y_value.number) return false;
+                break;
+            case LispType::String:
+                if (!(x_value.str() == y_value.str())) return false;
+                break;
+            case LispType::Symbol:
+            case LispType::BuiltinFunction:
+                if (x_value.symbol_id() != y_value.symbol_id()) return false;
+                break;
+            case LispType::LambdaFunction:
+                /* every lambda expression and partial application makes a distinct function */
+                if (x_value._object != y_value._object) return false;
+                break;
+            case LispType::S_Expression:
+            case LispType::Q_Expression: {
+                const LispListNode* x_node = static_cast<const LispListNode*>(x_value._object);
+                const LispListNode* y_node = static_cast<const LispListNode*>(y_value._object);
+                if (x_value.cells().size() != y_value.cells().size()) return false;
+                /* shared tails are equal without visiting them, nor are lists within lists now */
+                for (; x_node != y_node; x_node = x_node->tail, y_node = y_node->tail) {
+                    const LispValue& x_cell(x_node->head);
+                    const LispValue& y_cell(y_node->head);
+                    if (x_cell.type != y_cell.type) return false;
+                    if (x_cell.type == LispType::S_Expression || x_cell.type == LispType::Q_Expression) {
+                        pending.push_back({ &x_cell, &y_cell });
+                    } else if (x_cell != y_cell) {
+                        return false;
+                    }
+                }
+                break;
+            }
+            case LispType::Vector:
+                if (!(x_value.numbers() == y_value.numbers())) return false;
+                break;
+            case LispType::BigInteger:
+                /* numbers that fit in an int are never big integers, so the types tell them apart */
+                if (!(x_value.big_integer() == y_value.big_integer())) return false;
+                break;
+            case LispType::Float:
+                if (x_value.real() != y_value.real()) return false;
+                break;
+            default:
+                throw std::invalid_argument("Error: Unknown type");
+        }
+        if (pending.empty()) return true;
+        next = pending.back();
+        pending.pop_back();
     }
 }
 
@@ -57,11 +345,96 @@ bool operator !=(const LispValue & x, const LispValue& y) {
     return !(x == y);
 }
 
+size_t hash_value(const LispValue& value) {
+    /* every value in the same order for equal values, lists by type and length before their
+       cells, so that deeply nested lists do not overflow the stack */
+    std::vector<const LispValue*> pending;
+    const LispValue* next_value = &value;
+    size_t hash = 0;
+    while (true) {
+        const LispValue& next(*next_value);
+        const size_t type_hash = static_cast<size_t>(next.type);
+        size_t next_hash;
+        switch (next.type) {
+            case LispType::Unit:
+                next_hash = type_hash;
+                break;
+            case LispType::Number:
+                next_hash = combine_hashes(type_hash, std::hash<int>()(next.number));
+                break;
+            case LispType::String: {
+                const LispStringView string(next.str());
+                next_hash = combine_hashes(type_hash, hash_bytes(string.data(), string.size()));
+                break;
+            }
+            case LispType::Symbol:
+            case LispType::BuiltinFunction:
+                next_hash = combine_hashes(type_hash, std::hash<int>()(next.symbol_id()));
+                break;
+            case LispType::LambdaFunction:
+                next_hash = combine_hashes(type_hash, std::hash<const LispObject*>()(next._object));
+                break;
+            case LispType::S_Expression:
+            case LispType::Q_Expression:
+                next_hash = combine_hashes(type_hash, next.cells().size());
+                for (const LispValue& cell : next.cells()) {
+                    if (cell.type == LispType::S_Expression || cell.type == LispType::Q_Expression) {
+                        pending.push_back(&cell);
+                    } else {
+                        next_hash = combine_hashes(next_hash, hash_value(cell));
+                    }
+                }
+                break;
+            case LispType::Vector: {
+                const LispVectorView numbers(next.numbers());
+                next_hash = combine_hashes(type_hash, hash_bytes(numbers.data(), numbers.size() * sizeof(int)));
+                break;
+            }
+            case LispType::BigInteger: {
+                const LispBigInteger& integer(next.big_integer());
+                const std::vector<uint32_t>& magnitude(integer.magnitude());
+                next_hash = combine_hashes(
+                    combine_hashes(type_hash, integer.is_negative()),
+                    hash_bytes(magnitude.data(), magnitude.size() * sizeof(uint32_t))
+                );
+                break;
+            }
+            case LispType::Float: {
+                /* 0.0 and -0.0 are equal, so they must hash the same */
+                const double real = next.real() == 0.0 ? 0.0 : next.real();
+                next_hash = combine_hashes(type_hash, std::hash<double>()(real));
+                break;
+            }
+            default:
+                throw std::invalid_argument("Error: Unknown type");
+        }
+        hash = combine_hashes(hash, next_hash);
+        if (pending.empty()) return hash;
+        next_value = pending.back();
+        pending.pop_back();
+    }
+}
+
+LispValue LispValue::substr(size_t pos, size_t length) const {
+    LispStringObject* string = static_cast<LispStringObject*>(_object);
+    return LispValue(LispType::String, string->data + pos, length, string->owner());
+}
+
+LispValue LispValue::slice(size_t pos, size_t length) const {
+    LispVectorObject* vector = static_cast<LispVectorObject*>(_object);
+    if (length == vector->length) return *this;
+    LispValue result;
+    result.type = LispType::Vector;
+    result._object = new LispVectorObject(vector->data + pos, length, vector->owner());
+    return result;
+}
+
 std::string LispValue::type_name() const {
     switch (type) {
         case LispType::Unit:
             return "Unit";
         case LispType::Number:
+        case LispType::BigInteger:
             return "Number";
         case LispType::String:
             return "String";
@@ -75,17 +448,37 @@ std::string LispValue::type_name() const {
             return "S-Expression";
         case LispType::Q_Expression:
             return "Q-Expression";
+        case LispType::Vector:
+            return "Vector";
+        case LispType::Float:
+            return "Float";
         default:
             throw std::invalid_argument("Error: Unknown type");
     }
 }
 
 
-template<typename T>
-std::ostream& operator<<(std::ostream& os, const std::vector<T>& vector) {
-    for (size_t index = 0, size = vector.size(); index < size; index++) {
-        os << vector[index];
-        if (index != size - 1) os << ' ';
+std::ostream& operator<<(std::ostream& os, const LispCells& cells) {
+    for (LispCells::iterator itr = cells.begin(), end = cells.end(); itr != end;) {
+        os << *itr;
+        if (++itr != end) os << ' ';
+    }
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const LispVectorView& numbers) {
+    for (const int* itr = numbers.begin(), * end = numbers.end(); itr != end;) {
+        os << *itr;
+        if (++itr != end) os << ' ';
     }
     return os;
 }
+
+// FNV-1a
+inline size_t hash_bytes(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t index = 0; index < size; index++) hash = (hash ^ bytes[index]) * 1099511628211ull;
+    return static_cast<size_t>(hash);
+}
+
@@ -2,12 +2,23 @@
 #define _LISPVALUE_HPP_
 
 
+#include <atomic>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <array>
-#include <functional>
+#include <iterator>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <cstring>
+#include <ostream>
+#include "bignum.hpp"
+#include "gc.hpp"
+#include "parallel.hpp"
+#include "pool.hpp"
+#include "symboltable.hpp"
 
 
 enum class LispType {
@@ -19,170 +30,757 @@ enum class LispType {
     LambdaFunction,
     S_Expression,
     Q_Expression,
+    Vector,
+    BigInteger,
+    Float,
 };
 
 class LispValue;
 class LispEnvironment;
-using  LispBuiltinFunction = std::function<
-    LispValue(std::vector<LispValue>&, const std::shared_ptr<LispEnvironment>&)
->;
+using  LispBuiltinFunction = LispValue (*)(
+    std::vector<LispValue>&, const std::shared_ptr<LispEnvironment>&
+);
+
+class LispObject;
+class LispListNode;
+class LispCells;
+class LispMemoTable;
+
+// Numbers of a vector, packed next to each other.
+using LispPackedNumbers = std::vector<int, LispPoolAllocator<int>>;
+
+// Where a symbol in a lambda body is bound, relative to the call frame of that lambda.
+struct LispLexicalAddress {
+    unsigned long scope;    // lambda the address is valid for, 0 if unresolved
+    int depth;              // frames to go up, negative for a global symbol
+    int slot;               // parameter index in that frame
+};
+
+// Value a global symbol was last found at, valid as long as the version of the global
+// environment it was found in is the same.
+// The pointer is into a node of that environment's map, so every change that can free or move
+// the node must give the environment a new version: define_global adding a symbol, delete_global
+// removing one, and a collection emptying the map. Re-defining a symbol assigns to the node in
+// place and keeps the version. Versions come from one process-wide counter, so a cache filled
+// from one global environment, of any isolate, never matches another.
+struct LispGlobalCache {
+    unsigned long version;
+    const LispValue* value;
+};
+
+// Characters of a string value, valid as long as the value is.
+class LispStringView {
+    public:
+        LispStringView(const char* data, size_t size): _data(data), _size(size) {}
+
+        const char* data() const { return _data; }
+        size_t size() const { return _size; }
+        size_t length() const { return _size; }
+        bool empty() const { return _size == 0; }
+        std::string to_string() const { return std::string(_data, _size); }
+
+    private:
+        const char* _data;
+        size_t _size;
+};
+
+inline bool operator==(const LispStringView& x, const LispStringView& y) {
+    return x.size() == y.size() && std::memcmp(x.data(), y.data(), x.size()) == 0;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const LispStringView& view) {
+    return os.write(view.data(), view.size());
+}
+
+// Numbers of a vector value, valid as long as the value is.
+class LispVectorView {
+    public:
+        LispVectorView(const int* data, size_t size): _data(data), _size(size) {}
+
+        const int* data() const { return _data; }
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+        const int* begin() const { return _data; }
+        const int* end() const { return _data + _size; }
+        int operator[](size_t index) const { return _data[index]; }
+
+    private:
+        const int* _data;
+        size_t _size;
+};
+
+inline bool operator==(const LispVectorView& x, const LispVectorView& y) {
+    return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+}
 
 class LispValue {
     public:
         LispType type;
-        int number;
-        std::string str;
-        std::string symbol;
-        LispBuiltinFunction builtin_function;
-        std::shared_ptr<LispEnvironment> local_environment;
-        std::vector<LispValue> cells;
+        int number;     // interned id for symbols and built-in functions
 
         LispValue(LispType _type = LispType::Unit):
         type(_type),
         number(),
-        str(),
-        symbol(),
-        builtin_function(),
-        local_environment(),
-        cells()
+        _object()
         {}
 
         LispValue(LispType _type, const int value):
         type(_type),
         number(value),
-        str(),
-        symbol(),
-        builtin_function(),
-        local_environment(),
-        cells()
+        _object()
         {
             if (type != LispType::Number) {
                 throw std::invalid_argument("Error: type is not number");
             }
         }
 
-        LispValue(LispType _type, const std::string& value):
-        type(_type),
-        number(),
-        str(_type == LispType::String ? value : std::string()),
-        symbol(_type == LispType::Symbol ? value : std::string()),
-        builtin_function(),
-        local_environment(),
-        cells()
-        {
-            if (type != LispType::String && type != LispType::Symbol) {
-                throw std::invalid_argument("Error: type is neither string nor symbol");
-            }
-        }
+        LispValue(LispType _type, const std::string& value);
+
+        // string of the length characters at data, which stay valid as long as owner does
+        LispValue(LispType _type, const char* data, size_t length, LispObject* owner);
+
+        LispValue(LispType _type, int symbol_id, const LispLexicalAddress& address);
+
+        // built-in function named _symbol, which is all the value holds
+        LispValue(LispType _type, LispBuiltinFunction value, const std::string& _symbol);
 
         LispValue(
             LispType _type,
-            const LispBuiltinFunction& value,
-            const std::string& _symbol
-        ):
-        type(_type),
-        number(),
-        str(),
-        symbol(_symbol),
-        builtin_function(value),
-        local_environment(),
-        cells()
-        {
-            if (type != LispType::BuiltinFunction) {
-                throw std::invalid_argument("Error: type is not built-in function");
-            }
-        }
+            const LispValue& params,
+            const LispValue& body,
+            const std::shared_ptr<LispEnvironment>& environment,
+            unsigned long scope
+        );
 
+        // lambda function partially applied to bound_arguments
         LispValue(
             LispType _type,
-            const std::vector<LispValue>& value,
-            const std::shared_ptr<LispEnvironment>& environment
-        ):
-        type(_type),
-        number(),
-        str(),
-        symbol(),
-        builtin_function(),
-        local_environment(environment),
-        cells(value)
-        {
-            if (type != LispType::LambdaFunction) {
-                throw std::invalid_argument("Error: type is not lambda function");
+            const LispValue& lambda_function,
+            const std::vector<LispValue>& bound_arguments
+        );
+
+        // lambda function remembering its results in memo
+        LispValue(
+            LispType _type,
+            const LispValue& lambda_function,
+            const std::shared_ptr<LispMemoTable>& memo
+        );
+
+        LispValue(LispType _type, const std::vector<LispValue>& value);
+
+        // Q-Expression or S-Expression sharing every cell of tail after head
+        LispValue(LispType _type, const LispValue& head, const LispValue& tail);
+
+        LispValue(LispType _type, LispPackedNumbers&& numbers);
+
+        // number of any size, boxed as a big integer only when it does not fit in an int
+        LispValue(LispType _type, LispBigInteger&& value);
+
+        LispValue(LispType _type, double value);
+
+        LispValue(const LispValue& other);
+        LispValue(LispValue&& other) noexcept;
+        LispValue& operator=(const LispValue& other);
+        LispValue& operator=(LispValue&& other) noexcept;
+        ~LispValue();
+
+        LispStringView str() const;
+        LispVectorView numbers() const;
+        const LispBigInteger& big_integer() const;
+        double real() const;
+        const std::string& symbol() const;
+        int symbol_id() const;
+        const LispLexicalAddress& lexical_address() const;
+        LispGlobalCache& global_cache() const;
+        LispBuiltinFunction builtin_function() const;
+        const std::shared_ptr<LispEnvironment>& local_environment() const;
+        const LispValue& params() const;
+        const LispValue& body() const;
+        const std::vector<LispValue>& bound_arguments() const;
+        unsigned long scope() const;
+        const std::shared_ptr<LispMemoTable>& memo() const;
+        LispCells cells() const;
+
+        // expression without its first n cells, sharing the rest
+        LispValue drop(size_t n) const;
+
+        // length characters of a string from pos on, sharing its storage
+        LispValue substr(size_t pos, size_t length) const;
+
+        // length numbers of a vector from pos on, sharing its storage
+        LispValue slice(size_t pos, size_t length) const;
+
+        // compiled form of a non-empty expression, cached on its first cell; when two threads
+        // compile it at once, the first code set is kept and returned, and the other released
+        const LispObject* compiled() const;
+        const LispObject* set_compiled(LispObject* code) const;
+
+        std::string type_name() const;
+
+    private:
+        LispObject* _object;
+
+        void _release();
+
+    friend class LispCollector;
+    friend class LispImageWriter;
+    friend class LispListNode;
+    friend std::ostream& operator<<(std::ostream& os, const LispValue& value);
+    friend bool operator ==(const LispValue & x, const LispValue& y);
+    friend bool operator !=(const LispValue & x, const LispValue& y);
+    friend size_t hash_value(const LispValue& value);
+};
+
+// hash of a value that equal values share
+size_t hash_value(const LispValue& value);
+
+inline size_t combine_hashes(size_t seed, size_t hash) {
+    return seed ^ (hash + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+// Reference counts are only updated atomically while parallel tasks run, as objects are then
+// shared between threads; otherwise plain loads and stores do.
+class LispObject {
+    public:
+        std::atomic<size_t> reference_count;
+
+        LispObject(): reference_count(1) {}
+        virtual ~LispObject() {}
+
+        void retain() {
+            if (LispThreadPool::is_parallel()) {
+                reference_count.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                const size_t count = reference_count.load(std::memory_order_relaxed) + 1;
+                reference_count.store(count, std::memory_order_relaxed);
             }
         }
 
-        LispValue(LispType _type, const std::vector<LispValue>& value):
-        type(_type),
-        number(),
-        str(),
-        symbol(),
-        builtin_function(),
-        local_environment(),
-        cells(value)
+        // true when the last reference is gone
+        bool release() {
+            if (LispThreadPool::is_parallel()) {
+                return reference_count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+            }
+            const size_t count = reference_count.load(std::memory_order_relaxed) - 1;
+            reference_count.store(count, std::memory_order_relaxed);
+            return count == 0;
+        }
+
+        static void* operator new(size_t size) { return LispPool::allocate(size); }
+        static void operator delete(void* pointer, size_t size) { LispPool::deallocate(pointer, size); }
+};
+
+// Characters are either kept in the object itself or borrowed from an owner, which may be
+// another string or a mapped file.
+class LispStringObject : public LispObject {
+    private:
+        const std::string _storage;
+        LispObject* const _owner;
+
+    public:
+        const char* const data;
+        const size_t length;
+
+        LispStringObject(const std::string& value):
+        _storage(value), _owner(), data(_storage.data()), length(_storage.length())
+        {}
+
+        LispStringObject(const char* _data, size_t _length, LispObject* owner):
+        _storage(), _owner(owner), data(_data), length(_length)
+        {
+            _owner->retain();
+        }
+
+        ~LispStringObject() {
+            if (_owner && _owner->release()) delete _owner;
+        }
+
+        // object keeping the characters alive
+        LispObject* owner() { return _owner ? _owner : this; }
+};
+
+// Numbers are either kept in the object itself or borrowed from the vector they were
+// sliced out of.
+class LispVectorObject : public LispObject {
+    private:
+        const LispPackedNumbers _storage;
+        LispObject* const _owner;
+
+    public:
+        const int* const data;
+        const size_t length;
+
+        LispVectorObject(LispPackedNumbers&& numbers):
+        _storage(std::move(numbers)), _owner(), data(_storage.data()), length(_storage.size())
+        {}
+
+        LispVectorObject(const int* _data, size_t _length, LispObject* owner):
+        _storage(), _owner(owner), data(_data), length(_length)
         {
-            if (type != LispType::S_Expression && type != LispType::Q_Expression) {
-                throw std::invalid_argument("Error: type is not expression");
+            _owner->retain();
+        }
+
+        ~LispVectorObject() {
+            if (_owner && _owner->release()) delete _owner;
+        }
+
+        // object keeping the numbers alive
+        LispObject* owner() { return _owner ? _owner : this; }
+};
+
+class LispBigIntegerObject : public LispObject {
+    public:
+        const LispBigInteger value;
+
+        LispBigIntegerObject(LispBigInteger&& _value): value(std::move(_value)) {}
+};
+
+// Doubles are boxed, as the handle has no room for one beside its type.
+class LispFloatObject : public LispObject {
+    public:
+        const double value;
+
+        LispFloatObject(double _value): value(_value) {}
+};
+
+// Only symbols resolved inside a lambda body carry an object.
+class LispSymbolObject : public LispObject {
+    public:
+        const LispLexicalAddress address;
+        mutable LispGlobalCache cache;
+
+        LispSymbolObject(const LispLexicalAddress& _address): address(_address), cache() {}
+};
+
+// Built-in functions by the symbol id of their names, so that built-in function values
+// carry no object and are copied without touching a reference count.
+// Every isolate adds the same functions for the same ids, so that only the first one writes
+// them, under a lock; the table is kept in chunks that never move, so that finding a function
+// takes none.
+class LispBuiltinTable {
+    public:
+        static void add(int symbol_id, LispBuiltinFunction function) {
+            LispBuiltinTable& table(instance());
+            std::lock_guard<std::mutex> lock(table._mutex);
+            LispBuiltinFunction*& chunk(table._chunks[symbol_id / chunk_size]);
+            if (!chunk) chunk = new LispBuiltinFunction[chunk_size]();
+            if (chunk[symbol_id % chunk_size] != function) chunk[symbol_id % chunk_size] = function;
+        }
+
+        static LispBuiltinFunction function(int symbol_id) {
+            return instance()._chunks[symbol_id / chunk_size][symbol_id % chunk_size];
+        }
+
+    private:
+        /* as many ids as the symbol table has */
+        static const size_t chunk_size = 4096;
+        static const size_t num_chunks = 4096;
+
+        std::mutex _mutex;
+        LispBuiltinFunction* _chunks[num_chunks];
+
+        LispBuiltinTable(): _mutex(), _chunks() {}
+
+        static LispBuiltinTable& instance() {
+            /* never destroyed, like the symbol table */
+            static LispBuiltinTable* table = new LispBuiltinTable();
+            return *table;
+        }
+};
+
+class LispLambdaObject : public LispObject {
+    public:
+        const LispValue params;
+        const LispValue body;
+        const std::shared_ptr<LispEnvironment> environment;
+        const std::vector<LispValue> bound_arguments;
+        const unsigned long scope;
+        const std::shared_ptr<LispMemoTable> memo;     // null unless memoized
+
+        LispLambdaObject(
+            const LispValue& _params,
+            const LispValue& _body,
+            const std::shared_ptr<LispEnvironment>& _environment,
+            const std::vector<LispValue>& _bound_arguments,
+            unsigned long _scope,
+            const std::shared_ptr<LispMemoTable>& _memo
+        ):
+        params(_params),
+        body(_body),
+        environment(_environment),
+        bound_arguments(_bound_arguments),
+        scope(_scope),
+        memo(_memo)
+        {}
+};
+
+// One cell of an immutable expression; lists share their tails.
+class LispListNode : public LispObject {
+    public:
+        const LispValue head;
+        LispListNode* tail;
+        const size_t size;
+        mutable std::atomic<LispObject*> compiled;
+
+        LispListNode(const LispValue& _head, LispListNode* _tail):
+        head(_head), tail(_tail), size(_tail ? _tail->size + 1 : 1), compiled()
+        {
+            if (tail) tail->retain();
+        }
+
+        ~LispListNode() {
+            LispObject* code = compiled.load(std::memory_order_relaxed);
+            if (code && code->release()) delete code;
+
+            // release the tail and a nested list through a worklist, so that neither
+            // long nor deeply nested lists overflow the stack
+            release_later(tail);
+            tail = nullptr;
+            LispValue& nested = const_cast<LispValue&>(head);
+            if (
+                (nested.type == LispType::S_Expression || nested.type == LispType::Q_Expression) &&
+                nested._object
+            ) {
+                release_later(static_cast<LispListNode*>(nested._object));
+                nested._object = nullptr;
+            }
+
+            static thread_local bool is_releasing = false;
+            if (is_releasing) return;
+            is_releasing = true;
+            std::vector<LispListNode*>& pending(pending_release());
+            while (!pending.empty()) {
+                LispListNode* node = pending.back();
+                pending.pop_back();
+                delete node;
             }
+            is_releasing = false;
         }
 
-        std::string type_name() const;
+    private:
+        static std::vector<LispListNode*>& pending_release() {
+            /* never destroyed, since lists may still be released during static destruction */
+            static thread_local std::vector<LispListNode*>* pending = new std::vector<LispListNode*>();
+            return *pending;
+        }
 
-    friend std::ostream& operator<<(std::ostream& os, const LispValue& value);
-    friend bool operator ==(const LispValue & x, const LispValue& y);
-    friend bool operator !=(const LispValue & x, const LispValue& y);
+        static void release_later(LispListNode* node) {
+            if (node && node->release()) pending_release().push_back(node);
+        }
 };
 
+class LispCells {
+    public:
+        class iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = LispValue;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const LispValue*;
+                using reference         = const LispValue&;
+
+                iterator(const LispListNode* node): _node(node) {}
+                const LispValue& operator*() const { return _node->head; }
+                const LispValue* operator->() const { return &_node->head; }
+                iterator& operator++() { _node = _node->tail; return *this; }
+                bool operator==(const iterator& other) const { return _node == other._node; }
+                bool operator!=(const iterator& other) const { return _node != other._node; }
+
+            private:
+                const LispListNode* _node;
+        };
+
+        LispCells(const LispListNode* node): _node(node) {}
+
+        bool empty() const { return !_node; }
+        size_t size() const { return _node ? _node->size : 0; }
+        const LispValue& front() const { return _node->head; }
+        iterator begin() const { return iterator(_node); }
+        iterator end() const { return iterator(nullptr); }
+
+        const LispValue& operator[](size_t index) const {
+            const LispListNode* node = _node;
+            while (index--) node = node->tail;
+            return node->head;
+        }
+
+    private:
+        const LispListNode* _node;
+};
+
+
+inline LispValue::LispValue(const LispValue& other):
+type(other.type),
+number(other.number),
+_object(other._object)
+{
+    if (_object) _object->retain();
+}
+
+inline LispValue::LispValue(LispValue&& other) noexcept:
+type(other.type),
+number(other.number),
+_object(other._object)
+{
+    other._object = nullptr;
+}
+
+inline LispValue& LispValue::operator=(const LispValue& other) {
+    // other may live inside the payload released here, so read it first
+    const LispType other_type = other.type;
+    const int other_number = other.number;
+    LispObject* other_object = other._object;
+    if (other_object) other_object->retain();
+    _release();
+    type = other_type;
+    number = other_number;
+    _object = other_object;
+    return *this;
+}
+
+inline LispValue& LispValue::operator=(LispValue&& other) noexcept {
+    if (this != &other) {
+        const LispType other_type = other.type;
+        const int other_number = other.number;
+        LispObject* other_object = other._object;
+        other._object = nullptr;
+        _release();
+        type = other_type;
+        number = other_number;
+        _object = other_object;
+    }
+    return *this;
+}
+
+inline LispValue::~LispValue() {
+    _release();
+}
+
+inline LispStringView LispValue::str() const {
+    const LispStringObject* string = static_cast<const LispStringObject*>(_object);
+    return LispStringView(string->data, string->length);
+}
+
+inline LispVectorView LispValue::numbers() const {
+    const LispVectorObject* vector = static_cast<const LispVectorObject*>(_object);
+    return LispVectorView(vector->data, vector->length);
+}
+
+inline const LispBigInteger& LispValue::big_integer() const {
+    return static_cast<const LispBigIntegerObject*>(_object)->value;
+}
+
+inline double LispValue::real() const {
+    return static_cast<const LispFloatObject*>(_object)->value;
+}
+
+inline const std::string& LispValue::symbol() const {
+    return LispSymbolTable::name(number);
+}
+
+inline int LispValue::symbol_id() const {
+    return number;
+}
+
+inline const LispLexicalAddress& LispValue::lexical_address() const {
+    static const LispLexicalAddress unresolved = { 0, 0, 0 };
+    if (!_object) return unresolved;
+    return static_cast<const LispSymbolObject*>(_object)->address;
+}
+
+inline LispGlobalCache& LispValue::global_cache() const {
+    return static_cast<const LispSymbolObject*>(_object)->cache;
+}
+
+inline LispBuiltinFunction LispValue::builtin_function() const {
+    return LispBuiltinTable::function(number);
+}
+
+inline const std::shared_ptr<LispEnvironment>& LispValue::local_environment() const {
+    return static_cast<const LispLambdaObject*>(_object)->environment;
+}
+
+inline const LispValue& LispValue::params() const {
+    return static_cast<const LispLambdaObject*>(_object)->params;
+}
+
+inline const LispValue& LispValue::body() const {
+    return static_cast<const LispLambdaObject*>(_object)->body;
+}
+
+inline const std::vector<LispValue>& LispValue::bound_arguments() const {
+    return static_cast<const LispLambdaObject*>(_object)->bound_arguments;
+}
+
+inline unsigned long LispValue::scope() const {
+    return static_cast<const LispLambdaObject*>(_object)->scope;
+}
+
+inline const std::shared_ptr<LispMemoTable>& LispValue::memo() const {
+    return static_cast<const LispLambdaObject*>(_object)->memo;
+}
+
+inline LispCells LispValue::cells() const {
+    return LispCells(static_cast<const LispListNode*>(_object));
+}
+
+inline const LispObject* LispValue::compiled() const {
+    return static_cast<const LispListNode*>(_object)->compiled.load(std::memory_order_acquire);
+}
+
+inline const LispObject* LispValue::set_compiled(LispObject* code) const {
+    const LispListNode* node = static_cast<const LispListNode*>(_object);
+    LispObject* installed = nullptr;
+    if (node->compiled.compare_exchange_strong(installed, code, std::memory_order_acq_rel)) return code;
+    if (code->release()) delete code;
+    return installed;
+}
+
+inline void LispValue::_release() {
+    if (_object && _object->release()) delete _object;
+    _object = nullptr;
+}
+
 class LispEnvironment {
     public:
+        // global environment tracked by collector, printing to output and reporting errors
+        LispEnvironment(LispCollector& collector, std::ostream& output, std::ostream& errors)
+        : _envmap(),
+        _parent_environment(),
+        _global_environment(this),
+        _scope(),
+        _params(),
+        _slots(),
+        _output(&output),
+        _errors(&errors),
+        _collector(&collector),
+        _version(++_last_version),
+        _cache_hits(0),
+        _cache_misses(0),
+        _marked(),
+        _tracked(),
+        _previous_tracked(),
+        _next_tracked()
+        {
+            _collector->track(this);
+        }
+
+        // call frame of the lambda function created with scope, binding params to arguments
         LispEnvironment(
-            const std::shared_ptr<LispEnvironment>& parent = std::shared_ptr<LispEnvironment>()
+            const std::shared_ptr<LispEnvironment>& parent,
+            const LispValue& params,
+            unsigned long scope,
+            std::vector<LispValue>&& arguments
         )
-        : _envmap(), _parent_environment(parent)
-        {}
+        : _envmap(),
+        _parent_environment(parent),
+        _global_environment(parent->_global_environment),
+        _scope(scope),
+        _params(params),
+        _slots(std::move(arguments)),
+        _output(),
+        _errors(),
+        _collector(parent->_collector),
+        _version(),
+        _cache_hits(),
+        _cache_misses(),
+        _marked(),
+        _tracked(),
+        _previous_tracked(),
+        _next_tracked()
+        {
+            _collector->track(this);
+        }
 
-        LispValue resolve(const std::string& name) const {
-            envmap_itr itr = _envmap.find(name);
-            if (itr != _envmap.end()) return itr->second.value;
-            else if (_parent_environment) return _parent_environment->resolve(name);
-            throw std::out_of_range("Error: unbound symbol " + name);
+        ~LispEnvironment() {
+            _collector->untrack(this);
         }
 
-        void define_global(const std::string& name, const LispValue& value, bool is_reserved = false) {
-            if (!_parent_environment) {
-                envmap_itr itr = _envmap.find(name);
-                if (itr != _envmap.end() && itr->second.is_reserved) {
-                    throw std::invalid_argument("Error: cannnot re-define reserved symbol " + name);
-                }
-                _envmap[name] = {value, is_reserved};
+        LispEnvironment(const LispEnvironment&) = delete;
+        LispEnvironment& operator=(const LispEnvironment&) = delete;
+
+        LispValue resolve(int symbol_id) const {
+            const LispEnvironment* environment = this;
+            for (; environment->_parent_environment; environment = environment->_parent_environment.get()) {
+                const int slot = environment->find_slot(symbol_id);
+                if (slot >= 0) return environment->_slots[slot];
             }
-            else _parent_environment->define_global(name, value);
+            return _global_environment->resolve_global(symbol_id);
         }
 
-        void define_local(const std::string& name, const LispValue& value) {
-            _envmap[name] = {value, false};
+        LispValue resolve(const LispValue& symbol) const {
+            const LispLexicalAddress& address(symbol.lexical_address());
+            if (address.scope == 0 || address.scope != _scope) return resolve(symbol.symbol_id());
+            if (address.depth < 0) return _global_environment->resolve_global(symbol.symbol_id(), symbol.global_cache());
+
+            const LispEnvironment* environment = this;
+            for (int depth = address.depth; depth > 0; depth--) {
+                environment = environment->_parent_environment.get();
+            }
+            return environment->_slots[address.slot];
         }
 
-        void delete_global(const std::string& name) {
-            if (!_parent_environment) {
-                envmap_itr itr = _envmap.find(name);
-                if (itr != _envmap.end() && itr->second.is_reserved) {
-                    throw std::invalid_argument("Error: cannnot delete reserved symbol " + name);
-                }
-                _envmap.erase(name);
+        int find_slot(int symbol_id) const {
+            int found = -1, slot = 0;
+            for (const LispValue& param : _params.cells()) {
+                if (slot == static_cast<int>(_slots.size())) break;
+                if (param.symbol_id() == symbol_id) found = slot;
+                slot++;
             }
-            else _parent_environment->delete_global(name);
+            return found;
         }
 
-        void delete_local(const std::string& name) {
-            _envmap.erase(name);
+        const std::shared_ptr<LispEnvironment>& parent_environment() const {
+            return _parent_environment;
         }
 
-        bool is_reserved(const std::string& name) {
-            if (!_parent_environment) {
-                envmap_itr itr = _envmap.find(name);
-                return itr != _envmap.end() && itr->second.is_reserved;
+        // sinks of the global environment, which print writes to
+        std::ostream& output() const { return *_global_environment->_output; }
+        std::ostream& errors() const { return *_global_environment->_errors; }
+
+        LispCollector& collector() const { return *_collector; }
+
+        // lookups of global symbols in lambda bodies that were answered by their cache, or not
+        size_t cache_hits() const { return _global_environment->_cache_hits.load(); }
+        size_t cache_misses() const { return _global_environment->_cache_misses.load(); }
+
+        // The global environment is read-only to parallel tasks, so that they need no lock to
+        // look symbols up. Adding or deleting a symbol changes its version, which makes every
+        // cached lookup miss once; re-defining one keeps the entry the caches point to. See
+        // LispGlobalCache.
+        void define_global(int symbol_id, const LispValue& value, bool is_reserved = false) {
+            if (LispThreadPool::is_in_task()) {
+                throw std::invalid_argument(
+                    "Error: cannot define " + LispSymbolTable::name(symbol_id) + " in a parallel task");
             }
-            return _parent_environment->is_reserved(name);
+            LispEnvironment* global = _global_environment;
+            envmap_itr itr = global->_envmap.find(symbol_id);
+            if (itr != global->_envmap.end() && itr->second.is_reserved) {
+                throw std::invalid_argument(
+                    "Error: cannnot re-define reserved symbol " + LispSymbolTable::name(symbol_id));
+            }
+            if (itr == global->_envmap.end()) global->_version = ++_last_version;
+            global->_envmap[symbol_id] = {value, is_reserved};
+        }
+
+        void delete_global(int symbol_id) {
+            if (LispThreadPool::is_in_task()) {
+                throw std::invalid_argument(
+                    "Error: cannot delete " + LispSymbolTable::name(symbol_id) + " in a parallel task");
+            }
+            LispEnvironment* global = _global_environment;
+            envmap_itr itr = global->_envmap.find(symbol_id);
+            if (itr != global->_envmap.end() && itr->second.is_reserved) {
+                throw std::invalid_argument(
+                    "Error: cannnot delete reserved symbol " + LispSymbolTable::name(symbol_id));
+            }
+            if (global->_envmap.erase(symbol_id)) global->_version = ++_last_version;
+        }
+
+        bool is_reserved(int symbol_id) {
+            const LispEnvironment* global = _global_environment;
+            envmap_itr itr = global->_envmap.find(symbol_id);
+            return itr != global->_envmap.end() && itr->second.is_reserved;
         }
 
     private:
@@ -190,10 +788,63 @@ class LispEnvironment {
             LispValue value;
             bool is_reserved;
         };
-        using envmap_itr = std::unordered_map<std::string, MapValue>::const_iterator;
+        using envmap_itr = std::unordered_map<int, MapValue>::const_iterator;
+
+        /* only the global environment has a map, call frames keep arguments in slots */
+        std::unordered_map<int, MapValue> _envmap;
+        std::shared_ptr<LispEnvironment> _parent_environment;
+        LispEnvironment* const _global_environment;
+        const unsigned long _scope;
+        const LispValue _params;
+        std::vector<LispValue> _slots;
+        std::ostream* const _output;
+        std::ostream* const _errors;
+
+        /* every environment keeps its collector, which may outlive the global environment */
+        LispCollector* const _collector;
+
+        /* versions are unique across global environments, so that a cache filled by one of them
+           never answers for another */
+        static std::atomic<unsigned long> _last_version;
+        unsigned long _version;
+        mutable std::atomic<size_t> _cache_hits;
+        mutable std::atomic<size_t> _cache_misses;
 
-        std::unordered_map<std::string, MapValue> _envmap;
-        const std::shared_ptr<LispEnvironment> _parent_environment;
+        /* owned by LispCollector; only a collection empties the map, parent and slots */
+        bool _marked;
+        bool _tracked;
+        LispEnvironment* _previous_tracked;
+        LispEnvironment* _next_tracked;
+        friend class LispCollector;
+        friend class LispImageReader;
+        friend class LispImageWriter;
+        friend class LispListNode;
+
+        LispValue resolve_global(int symbol_id) const {
+            envmap_itr itr = _envmap.find(symbol_id);
+            if (itr != _envmap.end()) return itr->second.value;
+            throw std::out_of_range("Error: unbound symbol " + LispSymbolTable::name(symbol_id));
+        }
+
+        // Caches are only filled outside parallel tasks, which merely read them.
+        LispValue resolve_global(int symbol_id, LispGlobalCache& cache) const {
+            if (cache.version == _version) {
+                count(_cache_hits);
+                return *cache.value;
+            }
+            count(_cache_misses);
+            envmap_itr itr = _envmap.find(symbol_id);
+            if (itr == _envmap.end()) {
+                throw std::out_of_range("Error: unbound symbol " + LispSymbolTable::name(symbol_id));
+            }
+            if (!LispThreadPool::is_parallel()) cache = { _version, &itr->second.value };
+            return itr->second.value;
+        }
+
+        static void count(std::atomic<size_t>& counter) {
+            if (LispThreadPool::is_parallel()) counter.fetch_add(1, std::memory_order_relaxed);
+            else counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
 };
 
 #endif // _LISPVALUE_HPP_
@@ -1,24 +1,153 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <iomanip>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
 #include <editline/readline.h>
 
 #include "lispvalue.hpp"
 #include "parser.hpp"
+#include "builtin.hpp"
 #include "evaluation.hpp"
+#include "image.hpp"
+#include "isolate.hpp"
+#include "parallel.hpp"
+#include "profile.hpp"
+
+
+// Output of a script run in an isolate of its own, written out once every script is done.
+struct LispIsolatedRun {
+    std::ostringstream output;
+    std::ostringstream errors;
+    size_t failed;
+    int exit_status;
+    double seconds;
+};
+
+// Stacks file of --profile, which the profile is written out with as main returns.
+struct LispProfileReport {
+    std::ofstream stacks;
+
+    ~LispProfileReport() {
+        if (!stacks.is_open()) return;
+        std::cout.flush();
+        LispProfiler::report(std::cerr, stacks);
+    }
+};
+
+int run_repl(LispIsolate& isolate);
+inline bool has_operand(int index, int argc, char* argv[]);
+size_t run_timed(const std::string& name, LispIsolate& isolate, bool is_timed);
+int run_isolated(
+    const std::vector<std::string>& images,
+    const std::vector<std::string>& scripts,
+    bool is_timed
+);
 
 
 int main(int argc, char* argv[]) {
-    std::shared_ptr<LispEnvironment> global_env = global_environment();
+    bool is_timed = false;
+    bool is_isolated = false;
+    LispProfileReport profile_report;
+    std::vector<std::string> images;
+    std::vector<std::string> scripts;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--bytecode") == 0) {
+            select_engine(LispEngine::Bytecode);
+        } else if (std::strcmp(argv[i], "--time") == 0) {
+            is_timed = true;
+        } else if (std::strcmp(argv[i], "--isolates") == 0) {
+            is_isolated = true;
+        } else if (std::strcmp(argv[i], "--profile") == 0 && has_operand(i + 1, argc, argv)) {
+            profile_report.stacks.open(argv[++i]);
+            if (!profile_report.stacks) {
+                std::cerr << "Error: cannot open file " << argv[i] << std::endl;
+                return 1;
+            }
+            LispProfiler::enable();
+        } else if (std::strcmp(argv[i], "--image") == 0 && has_operand(i + 1, argc, argv)) {
+            images.push_back(argv[++i]);
+            /* checked here, so that isolates do not each fail on it after scripts have run */
+            if (!std::ifstream(images.back())) {
+                std::cerr << "Error: cannot open file " << images.back() << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc && std::atoi(argv[i + 1]) > 0) {
+            LispThreadPool::set_threads(std::atoi(argv[++i]));
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            std::cerr << "Usage: " << argv[0]
+                << " [--bytecode] [--time] [--profile file] [--threads n] [--isolates] [--image file ...] [script ...]" << std::endl;
+            return 1;
+        } else {
+            scripts.push_back(argv[i]);
+        }
+    }
+
+    /* each script runs in an isolate of its own, all of them at once */
+    if (is_isolated && !scripts.empty()) {
+        std::ios::sync_with_stdio(false);
+        return run_isolated(images, scripts, is_timed);
+    }
+
+    LispIsolate isolate(std::cout, std::cerr);
+
+    /* images hold definitions saved by save-image, loaded before any code runs */
+    for (const std::string& image : images) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        try {
+            load_image(image, isolate.environment());
+        } catch (const std::exception& exception) {
+            std::cerr << exception.what() << std::endl;
+            return 1;
+        }
+        if (is_timed) {
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cerr << image << ": " << std::fixed << std::setprecision(6) << elapsed.count() << "s" << std::endl;
+        }
+    }
+
+    if (scripts.empty()) {
+        if (isatty(STDIN_FILENO)) return run_repl(isolate);
+        /* piped input runs as a script, without prompts and history */
+        scripts.push_back("-");
+    }
 
+    /* scripts only go through iostreams, which need not stay in step with stdio */
+    std::ios::sync_with_stdio(false);
+
+    size_t failed = 0;
+    for (const std::string& script : scripts) {
+        failed += run_timed(script, isolate, is_timed);
+        if (isolate.has_exited()) return isolate.exit_status();
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+
+int run_repl(LispIsolate& isolate) {
+    const std::shared_ptr<LispEnvironment>& global_env(isolate.environment());
     std::cout << "Build Your Own Lisp" << std::endl;
     std::cout << "Press ctrl+c to Exit" << std::endl;
 
     while (true) {
-        std::string input(readline(">>> "));
+        char* line = readline(">>> ");
+        if (!line) break;
+        std::string input(line);
+        free(line);
         add_history(input.c_str());
         LispValue value;
         try {
             value = parse(input);
             value = evaluate(value, global_env);
+        } catch (const LispExit& exit) {
+            return exit.status;
         } catch (const std::exception& exception) {
             std::cerr << exception.what() << std::endl;
             continue;
@@ -26,6 +155,89 @@ int main(int argc, char* argv[]) {
         if (value.type != LispType::Unit) {
             std::cout << value << std::endl;
         }
+        value = LispValue();
+        global_env->collector().collect_if_needed();
     }
     return 0;
 }
+
+// Whether argv[index] is there to be the file an option takes, rather than another option,
+// so that --profile --time neither writes a file named --time nor leaves --time unread.
+inline bool has_operand(int index, int argc, char* argv[]) {
+    return index < argc && argv[index][0] != '-';
+}
+
+size_t run_timed(const std::string& name, LispIsolate& isolate, bool is_timed) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const size_t failed = isolate.run_file(name);
+    if (is_timed) {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout.flush();
+        std::cerr << (name == "-" ? "<stdin>" : name) << ": "
+            << std::fixed << std::setprecision(6) << elapsed.count() << "s" << std::endl;
+    }
+    return failed;
+}
+
+// Runs every script in an isolate of its own, on as many threads as the pool has, and writes
+// their output in the order of the scripts.
+int run_isolated(
+    const std::vector<std::string>& images,
+    const std::vector<std::string>& scripts,
+    bool is_timed
+) {
+    std::vector<std::unique_ptr<LispIsolatedRun>> runs;
+    for (size_t index = 0; index < scripts.size(); index++) {
+        runs.push_back(std::unique_ptr<LispIsolatedRun>(new LispIsolatedRun()));
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next_script(0);
+    std::vector<std::thread> threads;
+    const size_t num_threads = std::min(LispThreadPool::threads(), scripts.size());
+    const std::function<void()> run_scripts([&]() {
+        for (size_t index = next_script++; index < scripts.size(); index = next_script++) {
+            LispIsolatedRun& run(*runs[index]);
+            const std::chrono::steady_clock::time_point run_start = std::chrono::steady_clock::now();
+            {
+                LispIsolate isolate(run.output, run.errors);
+                try {
+                    for (const std::string& image : images) load_image(image, isolate.environment());
+                    run.failed = isolate.run_file(scripts[index]);
+                } catch (const std::exception& exception) {
+                    run.errors << exception.what() << std::endl;
+                    run.failed = 1;
+                }
+                run.exit_status = isolate.exit_status();
+            }
+            LispProfiler::fold_thread_profile();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - run_start;
+            run.seconds = elapsed.count();
+        }
+    });
+    /* the calling thread runs scripts too, so that a single thread never starts another */
+    for (size_t count = 1; count < num_threads; count++) threads.push_back(std::thread(run_scripts));
+    run_scripts();
+    for (std::thread& thread : threads) thread.join();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    int status = 0;
+    for (size_t index = 0; index < scripts.size(); index++) {
+        const LispIsolatedRun& run(*runs[index]);
+        std::cout << run.output.str();
+        std::cout.flush();
+        std::cerr << run.errors.str();
+        if (is_timed) {
+            std::cerr << (scripts[index] == "-" ? "<stdin>" : scripts[index]) << ": "
+                << std::fixed << std::setprecision(6) << run.seconds << "s" << std::endl;
+        }
+        if (status == 0 && run.exit_status != 0) status = run.exit_status;
+        if (status == 0 && run.failed != 0) status = 1;
+    }
+    if (is_timed) {
+        std::cerr << scripts.size() << " scripts on " << num_threads << " threads: "
+            << std::fixed << std::setprecision(6) << elapsed.count() << "s, "
+            << std::setprecision(2) << scripts.size() / elapsed.count() << " scripts/s" << std::endl;
+    }
+    return status;
+}
@@ -0,0 +1,33 @@
+#include "mappedfile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+LispMappedFile* LispMappedFile::open(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+    const size_t size = status.st_size;
+    if (size == 0) {
+        close(fd);
+        return new LispMappedFile(nullptr, 0);
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return nullptr;
+    madvise(data, size, MADV_SEQUENTIAL);
+    return new LispMappedFile(static_cast<const char*>(data), size);
+}
+
+LispMappedFile::~LispMappedFile() {
+    if (data) munmap(const_cast<char*>(data), size);
+}
@@ -0,0 +1,25 @@
+#ifndef _MAPPEDFILE_HPP_
+#define _MAPPEDFILE_HPP_
+
+
+#include <string>
+#include "lispvalue.hpp"
+
+
+// Read-only memory mapping of a whole file. Strings read from it borrow its bytes,
+// so the mapping lasts until the reader and the last of those strings are released.
+class LispMappedFile : public LispObject {
+    public:
+        const char* const data;
+        const size_t size;
+
+        // nullptr when path is not a regular file that can be mapped
+        static LispMappedFile* open(const std::string& path);
+
+        ~LispMappedFile();
+
+    private:
+        LispMappedFile(const char* _data, size_t _size): data(_data), size(_size) {}
+};
+
+#endif  // _MAPPEDFILE_HPP_
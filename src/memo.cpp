@@ -0,0 +1,79 @@
+#include "memo.hpp"
+
+
+inline std::unique_lock<std::mutex> lock_if_parallel(std::mutex& mutex);
+
+
+LispMemoTable::LispMemoTable(size_t capacity):
+_capacity(capacity),
+_entries(),
+_index(),
+_hits(),
+_misses(),
+_evictions(),
+_mutex()
+{}
+
+bool LispMemoTable::find(const std::vector<LispValue>& arguments, LispValue& result) {
+    std::unique_lock<std::mutex> lock(lock_if_parallel(_mutex));
+    auto itr = _index.find(&arguments);
+    if (itr == _index.end()) {
+        _misses++;
+        return false;
+    }
+    _hits++;
+    _entries.splice(_entries.begin(), _entries, itr->second);
+    result = itr->second->result;
+    return true;
+}
+
+void LispMemoTable::insert(const std::vector<LispValue>& arguments, const LispValue& result) {
+    std::unique_lock<std::mutex> lock(lock_if_parallel(_mutex));
+    /* parallel tasks may have computed the same result meanwhile */
+    auto itr = _index.find(&arguments);
+    if (itr != _index.end()) {
+        _entries.splice(_entries.begin(), _entries, itr->second);
+        itr->second->result = result;
+        return;
+    }
+    if (_entries.size() == _capacity) {
+        _index.erase(&_entries.back().arguments);
+        _entries.pop_back();
+        _evictions++;
+    }
+    _entries.push_front({ arguments, result });
+    _index.emplace(&_entries.front().arguments, _entries.begin());
+}
+
+size_t LispMemoTable::size() const {
+    std::unique_lock<std::mutex> lock(lock_if_parallel(_mutex));
+    return _entries.size();
+}
+
+size_t LispMemoTable::hits() const {
+    std::unique_lock<std::mutex> lock(lock_if_parallel(_mutex));
+    return _hits;
+}
+
+size_t LispMemoTable::misses() const {
+    std::unique_lock<std::mutex> lock(lock_if_parallel(_mutex));
+    return _misses;
+}
+
+size_t LispMemoTable::evictions() const {
+    std::unique_lock<std::mutex> lock(lock_if_parallel(_mutex));
+    return _evictions;
+}
+
+size_t LispMemoTable::ArgumentsHash::operator()(const std::vector<LispValue>* arguments) const {
+    size_t hash = arguments->size();
+    for (const LispValue& argument : *arguments) hash = combine_hashes(hash, hash_value(argument));
+    return hash;
+}
+
+
+inline std::unique_lock<std::mutex> lock_if_parallel(std::mutex& mutex) {
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (LispThreadPool::is_parallel()) lock.lock();
+    return lock;
+}
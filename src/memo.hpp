@@ -0,0 +1,60 @@
+#ifndef _MEMO_HPP_
+#define _MEMO_HPP_
+
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "lispvalue.hpp"
+
+
+// Results of a memoized lambda function by the arguments it was called with, compared with ==.
+// Beyond capacity, the result used least recently is forgotten. Parallel tasks may share a
+// table, which is then locked.
+class LispMemoTable {
+    public:
+        explicit LispMemoTable(size_t capacity);
+        LispMemoTable(const LispMemoTable&) = delete;
+        LispMemoTable& operator=(const LispMemoTable&) = delete;
+
+        // true and the result in result when arguments were remembered
+        bool find(const std::vector<LispValue>& arguments, LispValue& result);
+        void insert(const std::vector<LispValue>& arguments, const LispValue& result);
+
+        size_t capacity() const { return _capacity; }
+        size_t size() const;
+        size_t hits() const;
+        size_t misses() const;
+        size_t evictions() const;
+
+    private:
+        struct Entry {
+            std::vector<LispValue> arguments;
+            LispValue result;
+        };
+
+        struct ArgumentsHash {
+            size_t operator()(const std::vector<LispValue>* arguments) const;
+        };
+
+        struct ArgumentsEqual {
+            bool operator()(const std::vector<LispValue>* x, const std::vector<LispValue>* y) const {
+                return *x == *y;
+            }
+        };
+
+        const size_t _capacity;
+        std::list<Entry> _entries;          // most recently used first
+        std::unordered_map<
+            const std::vector<LispValue>*, std::list<Entry>::iterator, ArgumentsHash, ArgumentsEqual
+        > _index;                           // keys point to the arguments of the entries
+        size_t _hits;
+        size_t _misses;
+        size_t _evictions;
+        mutable std::mutex _mutex;
+        friend class LispCollector;
+};
+
+#endif  // _MEMO_HPP_
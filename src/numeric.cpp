@@ -0,0 +1,210 @@
+#include "numeric.hpp"
+
+/* LISP_SCALAR_KERNELS leaves the kernels to their scalar loops, to measure the vector ones by */
+#if defined(__SSE2__) && !defined(LISP_SCALAR_KERNELS)
+#define LISP_SSE2_KERNELS
+#include <emmintrin.h>
+#endif
+
+
+/* the kernels read the type and the number of four values at once from their first two words */
+static_assert(sizeof(LispValue) == 16, "LispValue is expected to take 16 bytes");
+
+template <LispOrder order> inline bool is_ordered_as(const LispValue* begin, const LispValue* end);
+template <bool is_subtraction, typename Operand> inline bool add_packed_as(int* x, Operand y, size_t length);
+inline int operand_at(const int* y, size_t index);
+inline int operand_at(int y, size_t index);
+#ifdef LISP_SSE2_KERNELS
+inline void load_values(const LispValue* values, __m128i& types, __m128i& numbers);
+inline __m128i load_operand(const int* y, size_t index);
+inline __m128i load_operand(int y, size_t index);
+#endif
+
+/* comparisons are specialized before any kernel is instantiated with them */
+template <LispOrder order> inline bool in_order(int x, int y);
+template <>
+inline bool in_order<LispOrder::Less>(int x, int y) { return x < y; }
+template <>
+inline bool in_order<LispOrder::LessEqual>(int x, int y) { return x <= y; }
+template <>
+inline bool in_order<LispOrder::Greater>(int x, int y) { return x > y; }
+template <>
+inline bool in_order<LispOrder::GreaterEqual>(int x, int y) { return x >= y; }
+
+#ifdef LISP_SSE2_KERNELS
+// Lanes where x stands in order to y.
+template <LispOrder order> inline __m128i in_order(__m128i x, __m128i y);
+template <>
+inline __m128i in_order<LispOrder::Less>(__m128i x, __m128i y) {
+    return _mm_cmplt_epi32(x, y);
+}
+
+template <>
+inline __m128i in_order<LispOrder::LessEqual>(__m128i x, __m128i y) {
+    return _mm_xor_si128(_mm_cmpgt_epi32(x, y), _mm_cmpeq_epi32(x, x));
+}
+
+template <>
+inline __m128i in_order<LispOrder::Greater>(__m128i x, __m128i y) {
+    return _mm_cmpgt_epi32(x, y);
+}
+
+template <>
+inline __m128i in_order<LispOrder::GreaterEqual>(__m128i x, __m128i y) {
+    return _mm_xor_si128(_mm_cmplt_epi32(x, y), _mm_cmpeq_epi32(x, x));
+}
+#endif
+
+
+bool sum_numbers(const LispValue* begin, const LispValue* end, LispNumericSums& sums) {
+    int64_t positive = 0, negative = 0;
+#ifdef LISP_SSE2_KERNELS
+    /* numbers are widened to 64 bits, where no run shorter than 2^32 can overflow */
+    const __m128i number_type = _mm_set1_epi32(static_cast<int>(LispType::Number));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i positives = zero, negatives = zero, mismatches = zero;
+    for (; end - begin >= 4; begin += 4) {
+        __m128i types, numbers;
+        load_values(begin, types, numbers);
+        mismatches = _mm_or_si128(mismatches, _mm_xor_si128(
+            _mm_cmpeq_epi32(types, number_type), _mm_cmpeq_epi32(zero, zero)));
+
+        const __m128i signs = _mm_srai_epi32(numbers, 31);
+        const __m128i positive_numbers = _mm_andnot_si128(signs, numbers);
+        const __m128i negative_numbers = _mm_and_si128(signs, numbers);
+        positives = _mm_add_epi64(positives, _mm_add_epi64(
+            _mm_unpacklo_epi32(positive_numbers, zero), _mm_unpackhi_epi32(positive_numbers, zero)));
+        negatives = _mm_add_epi64(negatives, _mm_add_epi64(
+            _mm_unpacklo_epi32(negative_numbers, signs), _mm_unpackhi_epi32(negative_numbers, signs)));
+    }
+    if (_mm_movemask_epi8(mismatches)) return false;
+
+    int64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), positives);
+    positive = lanes[0] + lanes[1];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), negatives);
+    negative = lanes[0] + lanes[1];
+#endif
+    for (; begin != end; begin++) {
+        if (begin->type != LispType::Number) return false;
+        if (begin->number > 0) positive += begin->number;
+        else                   negative += begin->number;
+    }
+    sums.positive = positive;
+    sums.negative = negative;
+    return true;
+}
+
+bool is_ordered(const LispValue* begin, const LispValue* end, LispOrder order) {
+    switch (order) {
+        case LispOrder::Less:
+            return is_ordered_as<LispOrder::Less>(begin, end);
+        case LispOrder::LessEqual:
+            return is_ordered_as<LispOrder::LessEqual>(begin, end);
+        case LispOrder::Greater:
+            return is_ordered_as<LispOrder::Greater>(begin, end);
+        case LispOrder::GreaterEqual:
+            return is_ordered_as<LispOrder::GreaterEqual>(begin, end);
+        default:
+            return false;
+    }
+}
+
+int64_t sum_packed(const int* begin, const int* end) {
+    int64_t total = 0;
+#ifdef LISP_SSE2_KERNELS
+    __m128i totals = _mm_setzero_si128();
+    for (; end - begin >= 4; begin += 4) {
+        const __m128i numbers = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        const __m128i signs = _mm_srai_epi32(numbers, 31);
+        totals = _mm_add_epi64(totals, _mm_add_epi64(
+            _mm_unpacklo_epi32(numbers, signs), _mm_unpackhi_epi32(numbers, signs)));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), totals);
+    total = lanes[0] + lanes[1];
+#endif
+    for (; begin != end; begin++) total += *begin;
+    return total;
+}
+
+bool add_packed(int* x, const int* y, size_t length, bool is_subtraction) {
+    return is_subtraction ? add_packed_as<true>(x, y, length) : add_packed_as<false>(x, y, length);
+}
+
+bool add_packed(int* x, int y, size_t length, bool is_subtraction) {
+    return is_subtraction ? add_packed_as<true>(x, y, length) : add_packed_as<false>(x, y, length);
+}
+
+
+template <LispOrder order>
+inline bool is_ordered_as(const LispValue* begin, const LispValue* end) {
+    if (begin == end) return true;
+#ifdef LISP_SSE2_KERNELS
+    /* each number against the next, four pairs at a time */
+    for (; end - begin >= 5; begin += 4) {
+        __m128i types, left, right;
+        load_values(begin, types, left);
+        load_values(begin + 1, types, right);
+        if (_mm_movemask_epi8(in_order<order>(left, right)) != 0xffff) return false;
+    }
+#endif
+    for (const LispValue* next = begin + 1; next != end; begin++, next++) {
+        if (!in_order<order>(begin->number, next->number)) return false;
+    }
+    return true;
+}
+
+template <bool is_subtraction, typename Operand>
+inline bool add_packed_as(int* x, Operand y, size_t length) {
+    size_t index = 0;
+#ifdef LISP_SSE2_KERNELS
+    /* a lane overflows when its result has the sign of neither x nor y, or of y alone on subtraction */
+    __m128i overflows = _mm_setzero_si128();
+    for (; length - index >= 4; index += 4) {
+        __m128i* lanes = reinterpret_cast<__m128i*>(x + index);
+        const __m128i left = _mm_loadu_si128(lanes);
+        const __m128i right = load_operand(y, index);
+        const __m128i result = is_subtraction ? _mm_sub_epi32(left, right) : _mm_add_epi32(left, right);
+        overflows = _mm_or_si128(overflows, is_subtraction
+            ? _mm_and_si128(_mm_xor_si128(left, right), _mm_xor_si128(left, result))
+            : _mm_and_si128(_mm_xor_si128(left, result), _mm_xor_si128(right, result)));
+        _mm_storeu_si128(lanes, result);
+    }
+    if (_mm_movemask_ps(_mm_castsi128_ps(overflows))) return false;
+#endif
+    for (; index < length; index++) {
+        const bool overflows = is_subtraction
+            ? __builtin_sub_overflow(x[index], operand_at(y, index), &x[index])
+            : __builtin_add_overflow(x[index], operand_at(y, index), &x[index]);
+        if (overflows) return false;
+    }
+    return true;
+}
+
+#ifdef LISP_SSE2_KERNELS
+inline void load_values(const LispValue* values, __m128i& types, __m128i& numbers) {
+    const __m128i* words = reinterpret_cast<const __m128i*>(values);
+    const __m128i first = _mm_unpacklo_epi32(_mm_loadu_si128(words), _mm_loadu_si128(words + 1));
+    const __m128i second = _mm_unpacklo_epi32(_mm_loadu_si128(words + 2), _mm_loadu_si128(words + 3));
+    types = _mm_unpacklo_epi64(first, second);
+    numbers = _mm_unpackhi_epi64(first, second);
+}
+
+// Operands are four numbers of a run at a time, or one number for all of them.
+inline __m128i load_operand(const int* y, size_t index) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + index));
+}
+
+inline __m128i load_operand(int y, size_t index) {
+    return _mm_set1_epi32(y);
+}
+#endif
+
+inline int operand_at(const int* y, size_t index) {
+    return y[index];
+}
+
+inline int operand_at(int y, size_t index) {
+    return y;
+}
@@ -0,0 +1,38 @@
+#ifndef _NUMERIC_HPP_
+#define _NUMERIC_HPP_
+
+
+#include <cstdint>
+#include "lispvalue.hpp"
+
+
+// Sums of the positive and of the negative numbers of a run, which bound every partial sum.
+struct LispNumericSums {
+    int64_t positive;
+    int64_t negative;
+};
+
+enum class LispOrder {
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+};
+
+// Kernels over runs of values laid out in memory, vectorized where SSE2 is available.
+
+// Adds up the numbers in [begin, end) without overflow; false if any value is not a number.
+bool sum_numbers(const LispValue* begin, const LispValue* end, LispNumericSums& sums);
+
+// Whether each number in [begin, end) stands in order to the next one. Every value must be a number.
+bool is_ordered(const LispValue* begin, const LispValue* end, LispOrder order);
+
+// Sum of the packed numbers in [begin, end), which fits in 64 bits for any run shorter than 2^32.
+int64_t sum_packed(const int* begin, const int* end);
+
+// Adds y to, or subtracts it from, each of the length numbers at x, number by number when y is
+// packed as well. False if any of them overflows, leaving x partly updated.
+bool add_packed(int* x, const int* y, size_t length, bool is_subtraction);
+bool add_packed(int* x, int y, size_t length, bool is_subtraction);
+
+#endif  // _NUMERIC_HPP_
@@ -0,0 +1,193 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "allocation.hpp"
+#include "evaluation.hpp"
+#include "pool.hpp"
+#include "profile.hpp"
+
+
+// Tasks of one run, which is over when none of them remains.
+struct LispTaskGroup {
+    const std::function<void(size_t)>* task;
+    std::atomic<size_t> failed_index;
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining;                   // guarded by mutex, as is failure
+    std::exception_ptr failure;
+};
+
+struct LispTask {
+    LispTaskGroup* group;
+    size_t index;
+};
+
+struct LispTaskDeque {
+    std::mutex mutex;
+    std::deque<LispTask> tasks;
+};
+
+// Deques of the workers after the one for threads outside the pool, which all share it.
+struct LispWorkers {
+    std::vector<std::unique_ptr<LispTaskDeque>> deques;
+    std::atomic<size_t> queued;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+};
+
+std::atomic<int> LispThreadPool::_sections(0);
+
+static size_t thread_count = 0;
+static std::once_flag workers_started;
+
+/* never destroyed, since detached workers still wait on it during static destruction */
+static LispWorkers* workers = nullptr;
+
+static thread_local size_t deque_index = 0;
+static thread_local int task_depth = 0;
+
+
+inline void start_workers();
+inline void work(size_t index);
+inline bool take_task(LispTask& task);
+inline void run_task(const LispTask& task);
+
+
+void LispThreadPool::set_threads(size_t count) {
+    thread_count = count;
+}
+
+size_t LispThreadPool::threads() {
+    if (thread_count == 0) thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    return thread_count;
+}
+
+void LispThreadPool::run(size_t count, const std::function<void(size_t)>& task) {
+    if (threads() == 1 || count <= 1) {
+        /* nothing to share, so the tasks simply run in order */
+        task_depth++;
+        try {
+            for (size_t index = 0; index < count; index++) task(index);
+        } catch (...) {
+            task_depth--;
+            throw;
+        }
+        task_depth--;
+        return;
+    }
+    std::call_once(workers_started, start_workers);
+
+    LispTaskGroup group;
+    group.task = &task;
+    group.failed_index = std::numeric_limits<size_t>::max();
+    group.remaining = count;
+
+    _sections++;
+    workers->queued += count;
+    LispTaskDeque& own(*workers->deques[deque_index]);
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        for (size_t index = 0; index < count; index++) own.tasks.push_back({ &group, index });
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers->sleep_mutex);
+    }
+    workers->wake.notify_all();
+
+    /* the group lives on this stack, so it is only left under its lock once nothing remains */
+    while (true) {
+        LispTask next;
+        if (take_task(next)) {
+            run_task(next);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(group.mutex);
+        if (group.remaining == 0) break;
+        group.done.wait(lock);
+    }
+    _sections--;
+
+    if (group.failure) std::rethrow_exception(group.failure);
+}
+
+bool LispThreadPool::is_in_task() {
+    return task_depth > 0;
+}
+
+
+inline void start_workers() {
+    workers = new LispWorkers();
+    workers->queued = 0;
+    for (size_t index = 0; index < thread_count; index++) {
+        workers->deques.push_back(std::unique_ptr<LispTaskDeque>(new LispTaskDeque()));
+    }
+    for (size_t index = 1; index < thread_count; index++) std::thread(work, index).detach();
+}
+
+inline void work(size_t index) {
+    deque_index = index;
+    while (true) {
+        LispTask next;
+        if (take_task(next)) {
+            run_task(next);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(workers->sleep_mutex);
+        workers->wake.wait(lock, [] { return workers->queued.load() != 0; });
+    }
+}
+
+// The newest task of this thread's deque, or else the oldest one of the next deque that has any.
+inline bool take_task(LispTask& task) {
+    if (workers->queued.load() == 0) return false;
+    const size_t size = workers->deques.size();
+    for (size_t offset = 0; offset < size; offset++) {
+        LispTaskDeque& deque(*workers->deques[(deque_index + offset) % size]);
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        if (deque.tasks.empty()) continue;
+        if (offset == 0) {
+            task = deque.tasks.back();
+            deque.tasks.pop_back();
+        } else {
+            task = deque.tasks.front();
+            deque.tasks.pop_front();
+        }
+        workers->queued--;
+        return true;
+    }
+    return false;
+}
+
+inline void run_task(const LispTask& task) {
+    LispTaskGroup& group(*task.group);
+    if (task.index < group.failed_index.load()) {
+        task_depth++;
+        try {
+            (*group.task)(task.index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(group.mutex);
+            if (task.index < group.failed_index.load()) {
+                group.failed_index = task.index;
+                group.failure = std::current_exception();
+            }
+        }
+        task_depth--;
+    }
+
+    /* counts of this thread are folded into the totals before the run can be seen to end */
+    fold_thread_allocations();
+    fold_thread_calls();
+    LispPool::fold_thread_counts();
+    LispProfiler::fold_thread_profile();
+
+    std::lock_guard<std::mutex> lock(group.mutex);
+    if (--group.remaining == 0) group.done.notify_all();
+}
@@ -0,0 +1,35 @@
+#ifndef _PARALLEL_HPP_
+#define _PARALLEL_HPP_
+
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+
+// Work-stealing pool of threads for the parallel built-in functions.
+// Every thread has a deque of tasks: it takes its own newest task first and, when it has none,
+// steals the oldest task of another thread. A thread waiting for its tasks runs tasks meanwhile,
+// so that tasks can start parallel work of their own.
+class LispThreadPool {
+    public:
+        // threads to run tasks on, the calling thread included; only taken before the first run
+        static void set_threads(size_t count);
+        static size_t threads();
+
+        // Runs task(0) to task(count - 1) and returns once all of them are done. When tasks throw,
+        // the exception of the lowest index is rethrown, and the tasks after it may be skipped.
+        static void run(size_t count, const std::function<void(size_t)>& task);
+
+        // Whether tasks may be running on several threads, so that objects reachable from more
+        // than one of them are to be updated atomically.
+        static bool is_parallel() { return _sections.load(std::memory_order_relaxed) != 0; }
+
+        // Whether the calling thread is running a task.
+        static bool is_in_task();
+
+    private:
+        static std::atomic<int> _sections;     // runs in progress on more than one thread
+};
+
+#endif  // _PARALLEL_HPP_
@@ -1,131 +1,397 @@
 #include "parser.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <string>
+#include <sstream>
+#include "floating.hpp"
 #include "lispvalue.hpp"
 
+/* LISP_SCALAR_LEXER leaves the reader to its per-character loops, to measure the scanners by */
+#if defined(__SSE2__) && !defined(LISP_SCALAR_LEXER)
+#define LISP_SSE2_LEXER
+#include <emmintrin.h>
+#endif
+
 
 const std::string white_spaces(" \t\r\n\f");
 const std::string symbol_characters(
     "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPPQRSTUVWXYZ_+-*/%^=<>&|!");
 const std::string number_characters("0123456789");
 const char positive_sign = '+', negative_sign = '-';
+const char decimal_point = '.';
 const char sexpr_lparen = '(', sexpr_rparen = ')';
 const char qexpr_lparen = '{', qexpr_rparen = '}';
 const char string_paren = '\"', string_escape = '\\';
+const char newline = '\n';
+const size_t buffer_size = 64 * 1024;
+const long short_run = 16;
+
+// Character classes of all 256 byte values, built from the character sets above.
+class LispCharacterTable {
+    public:
+        static const unsigned char blank = 1;       // white space other than newline
+        static const unsigned char symbol = 2;
+        static const unsigned char number = 4;
+        static const unsigned char atom = symbol | number;
+
+        LispCharacterTable(): _classes() {
+            for (const char c : white_spaces) {
+                if (c != newline) _classes[static_cast<unsigned char>(c)] |= blank;
+            }
+            for (const char c : symbol_characters) _classes[static_cast<unsigned char>(c)] |= symbol;
+            for (const char c : number_characters) _classes[static_cast<unsigned char>(c)] |= number;
+        }
+
+        bool is(char c, unsigned char character_class) const {
+            return _classes[static_cast<unsigned char>(c)] & character_class;
+        }
+
+    private:
+        unsigned char _classes[256];
+};
+
+static const LispCharacterTable character_table;
 
 
-LispValue parse_lisp(const std::string& input, size_t& pos);
-LispValue parse_atom(const std::string& input, size_t& pos);
-LispValue parse_string(const std::string& input, size_t& pos);
-LispValue parse_expr(const std::string& input, size_t& pos);
-inline void skip_whitespaces(const std::string& input, size_t& pos);
+inline const char* scan_blanks(const char* begin, const char* end);
+inline const char* scan_atom(const char* begin, const char* end);
 inline std::string error_message(size_t pos, const std::string& message, bool is_end = false);
 
 
 LispValue parse(const std::string& input) {
-    size_t pos = 0;
-    LispValue result = parse_lisp(sexpr_lparen + input + sexpr_rparen, pos);
-    if (pos - 2 != input.length()) {
-        throw std::invalid_argument(error_message(pos, "Error: fail to parse input"));
-    }
+    std::istringstream stream(input);
+    LispReader reader(stream);
+    LispValue result;
+    reader.read(result);
     return result;
 }
 
-LispValue parse_lisp(const std::string& input, size_t& pos) {
-    skip_whitespaces(input, pos);
-    if (pos == input.length()) {
-        throw std::invalid_argument(error_message(pos, "Error: unexpected end of input", true));
+
+LispReader::LispReader(std::istream& input)
+: _input(input.rdbuf()),
+_mapping(),
+_buffer(buffer_size),
+_cursor(),
+_end(),
+_frames(),
+_open(),
+_atom(),
+_line(1),
+_form_line(),
+_position(),
+_after_newline(),
+_depth()
+{}
+
+LispReader::LispReader(LispMappedFile* file)
+: _input(),
+_mapping(file),
+_buffer(),
+_cursor(file->data),
+_end(file->data + file->size),
+_frames(),
+_open(),
+_atom(),
+_line(1),
+_form_line(),
+_position(),
+_after_newline(),
+_depth()
+{}
+
+LispReader::~LispReader() {
+    if (_mapping && _mapping->release()) delete _mapping;
+}
+
+bool LispReader::read(LispValue& form) {
+    /* blank lines are skipped, but the first line of a form is kept whole */
+    size_t leading = 0;
+    while (true) {
+        const int c = peek();
+        if (c == end_of_input) return false;
+        if (c == newline) {
+            _cursor++;
+            _line++;
+            leading = 0;
+        } else if (character_table.is(c, LispCharacterTable::blank)) {
+            const char* blanks_end = scan_blanks(_cursor, _end);
+            leading += blanks_end - _cursor;
+            _cursor = blanks_end;
+        } else {
+            break;
+        }
     }
-    
-    LispValue result;
-    const char c = input[pos];
-    if (
-        symbol_characters.find(c) != std::string::npos || 
-        number_characters.find(c) != std::string::npos
-    ) {
-        result = parse_atom(input, pos);
-    } else if (c == string_paren) {
-        result = parse_string(input, pos);
-    } else if (c == sexpr_lparen || c == qexpr_lparen) {
-        result = parse_expr(input, pos);
-    } else {
-        std::string invalid(1, c);
-        throw std::invalid_argument(error_message(pos, "Error: unexpected character " + invalid));
+
+    /* positions in errors count from the implicit paren around the form */
+    _form_line = _line;
+    _position = leading;
+    _after_newline = false;
+    _open = 0;
+    open_frame(sexpr_lparen);
+    _depth = 0;
+
+    while (true) {
+        const int c = peek();
+        if (c == end_of_input) {
+            if (_open > 1) fail_at_end("Error: unexpected end of input");
+            break;
+        }
+        if (c == newline) {
+            get();
+            if (_open == 1) break;
+            continue;
+        }
+
+        if (character_table.is(c, LispCharacterTable::blank)) {
+            advance(scan_blanks(_cursor, _end) - _cursor);
+        } else if (character_table.is(c, LispCharacterTable::atom)) {
+            read_atom();
+        } else if (c == string_paren) {
+            read_string();
+        } else if (c == sexpr_lparen || c == qexpr_lparen) {
+            get();
+            open_frame(static_cast<char>(c));
+        } else if (c == _frames[_open - 1].rparen && _open > 1) {
+            get();
+            close_frame();
+        } else if (c == sexpr_rparen && _open == 1) {
+            /* a stray paren closes the form early, leaving the rest unparsed */
+            get();
+            _depth--;
+            while (peek() != end_of_input && character_table.is(*_cursor, LispCharacterTable::blank)) {
+                advance(scan_blanks(_cursor, _end) - _cursor);
+            }
+            fail(_position + 1, "Error: fail to parse input");
+        } else {
+            const std::string invalid(1, static_cast<char>(c));
+            fail(_position + 1, "Error: unexpected character " + invalid);
+        }
     }
-    skip_whitespaces(input, pos);
-    return result;
+
+    std::vector<LispValue>& cells(_frames[0].cells);
+    form = cells.empty() ? LispValue(LispType::Unit) : LispValue(LispType::S_Expression, cells);
+    cells.clear();
+    _open = 0;
+    return true;
 }
 
-LispValue parse_atom(const std::string& input, size_t& pos) {
-    size_t top = pos;
-    char c = input[pos];
-    std::string atom;
-    while (
-        symbol_characters.find(c) != std::string::npos ||
-        number_characters.find(c) != std::string::npos
-    ) {
-        atom.push_back(input[pos]);
-        pos++;
-        c = input[pos];
+int LispReader::get() {
+    const int c = peek();
+    if (c == end_of_input) return c;
+    _cursor++;
+    _position++;
+    _after_newline = c == newline;
+    if (_after_newline) _line++;
+    return c;
+}
+
+bool LispReader::refill() {
+    if (!_input) return false;
+
+    /* take what the stream has at hand, so that a pipe is never waited on for more */
+    std::streamsize available = _input->in_avail();
+    if (available <= 0) {
+        if (_input->sgetc() == end_of_input) return false;
+        available = std::max<std::streamsize>(_input->in_avail(), 1);
     }
+    const std::streamsize count = _input->sgetn(
+        _buffer.data(), std::min<std::streamsize>(available, _buffer.size()));
+    _cursor = _buffer.data();
+    _end = _cursor + count;
+    return count > 0;
+}
+
+void LispReader::read_atom() {
+    const size_t top = _position + 1;
+    _atom.clear();
+    append_atom();
 
+    const char first = _atom[0];
     if (
-        number_characters.find(atom[0]) == std::string::npos &&
-        (atom.length() < 2 ||
-         (atom[0] != positive_sign && atom[0] != negative_sign) ||
-         number_characters.find(atom[1]) == std::string::npos)
+        !character_table.is(first, LispCharacterTable::number) &&
+        (_atom.length() < 2 ||
+         (first != positive_sign && first != negative_sign) ||
+         !character_table.is(_atom[1], LispCharacterTable::number))
     ) {
-        return LispValue(LispType::Symbol, atom);
+        _frames[_open - 1].cells.push_back(LispValue(LispType::Symbol, _atom));
+        return;
     }
-    
-    for (size_t index = 1, len = atom.length(); index < len; index++) {
-        if (number_characters.find(atom[index]) == std::string::npos) {
-            throw std::invalid_argument(error_message(top, "Error: invalid symbol " + atom));
+
+    /* the point is no atom character: it only goes on a number, so that .5, a.b and . fail */
+    if (peek() == decimal_point) {
+        _atom.push_back(static_cast<char>(get()));
+        append_atom();
+    }
+
+    const bool is_negative = first == negative_sign;
+    const long long limit = is_negative ?
+        -static_cast<long long>(std::numeric_limits<int>::min()) : std::numeric_limits<int>::max();
+    const size_t digits_begin = character_table.is(first, LispCharacterTable::number) ? 0 : 1;
+    long long number = 0;
+    bool is_overflow = false;
+    for (size_t index = digits_begin, len = _atom.length(); index < len; index++) {
+        if (!character_table.is(_atom[index], LispCharacterTable::number)) {
+            /* a point or an exponent makes a floating-point number */
+            double real;
+            if (!parse_floating(_atom, real)) fail(top, "Error: invalid symbol " + _atom);
+            _frames[_open - 1].cells.push_back(LispValue(LispType::Float, real));
+            return;
+        }
+        number = number * 10 + (_atom[index] - '0');
+        if (number > limit) {
+            is_overflow = true;
+            number = limit;
         }
     }
-    try {
-        return LispValue(LispType::Number, std::stoi(atom));
-    } catch (const std::exception&) {
-        throw std::invalid_argument(error_message(top, "Error: fail to convert to a number"));
+    if (is_overflow) {
+        /* too large for an int, the literal becomes a big integer */
+        _frames[_open - 1].cells.push_back(LispValue(LispType::Number, LispBigInteger(_atom)));
+        return;
     }
+    _frames[_open - 1].cells.push_back(
+        LispValue(LispType::Number, static_cast<int>(is_negative ? -number : number)));
 }
 
-LispValue parse_string(const std::string& input, size_t& pos) {
-    size_t begin = pos + 1;
+void LispReader::append_atom() {
+    /* the atom may go on in the next buffer */
+    do {
+        const char* atom_end = scan_atom(_cursor, _end);
+        _atom.append(_cursor, atom_end);
+        advance(atom_end - _cursor);
+    } while (_cursor == _end && refill());
+}
+
+void LispReader::read_string() {
+    get();
+    const char* const body = _cursor;
+    _atom.clear();
     while (true) {
-        pos++;
-        if (pos == input.length()) {
-            throw std::invalid_argument(
-                error_message(pos, "Error: unexpected end of input", true));
+        if (_cursor == _end && !refill()) fail_at_end("Error: unexpected end of input");
+
+        /* memchr is vectorized by the C library */
+        const char* quote = static_cast<const char*>(std::memchr(_cursor, string_paren, _end - _cursor));
+        const char* body_end = quote ? quote : _end;
+        const long newlines = std::count(_cursor, body_end, newline);
+        if (body_end != _cursor) {
+            _after_newline = body_end[-1] == newline;
         }
-        if (input[pos] == string_paren) break;
+        if (!_mapping) _atom.append(_cursor, body_end);
+        _line += newlines;
+        _position += body_end - _cursor;
+        _cursor = body_end;
+        if (quote) break;
     }
-    std::string str(input.substr(begin, pos - begin));
-    pos++;
-    return LispValue(LispType::String, str);
-}
-
-LispValue parse_expr(const std::string& input, size_t& pos) {
-    const char lparen = input[pos];
-    const char rparen = lparen == sexpr_lparen ? sexpr_rparen : qexpr_rparen;
-    LispValue result(lparen == sexpr_lparen ? LispType::S_Expression : LispType::Q_Expression);
-    pos++;
-    while (input[pos] != rparen) {
-        result.cells.push_back(parse_lisp(input, pos));
+
+    /* a mapped file is never refilled, so the whole body lies in it */
+    _frames[_open - 1].cells.push_back(_mapping ?
+        LispValue(LispType::String, body, _cursor - body, _mapping) :
+        LispValue(LispType::String, _atom)
+    );
+    get();
+}
+
+void LispReader::open_frame(char lparen) {
+    if (_open == _frames.size()) _frames.push_back(Frame());
+    Frame& frame = _frames[_open++];
+    frame.type = lparen == sexpr_lparen ? LispType::S_Expression : LispType::Q_Expression;
+    frame.rparen = lparen == sexpr_lparen ? sexpr_rparen : qexpr_rparen;
+    frame.cells.clear();
+    _depth++;
+}
+
+void LispReader::close_frame() {
+    Frame& frame = _frames[--_open];
+    _depth--;
+    if (frame.type == LispType::S_Expression && frame.cells.empty()) {
+        _frames[_open - 1].cells.push_back(LispValue(LispType::Unit));
+    } else {
+        _frames[_open - 1].cells.push_back(LispValue(frame.type, frame.cells));
+        frame.cells.clear();
     }
-    pos++;
-    if (result.type == LispType::S_Expression && result.cells.empty()) {
-        result.type = LispType::Unit;
+}
+
+void LispReader::fail(size_t pos, const std::string& message) {
+    /* the rest of the form is found the same way as its end, by counting brackets */
+    const std::string error(error_message(pos, message));
+    bool in_string = false;
+    for (int c = get(); c != end_of_input; c = get()) {
+        if (c == string_paren) in_string = !in_string;
+        else if (in_string) continue;
+        else if (c == sexpr_lparen || c == qexpr_lparen) _depth++;
+        else if (c == sexpr_rparen || c == qexpr_rparen) _depth--;
+        else if (c == newline && _depth <= 0) break;
     }
-    return result;
+    _open = 0;
+    throw std::invalid_argument(error);
 }
 
-inline void skip_whitespaces(const std::string& input, size_t& pos) {
-    char c = input[pos];
-    while (pos < input.length() && white_spaces.find(c) != std::string::npos) {
-        pos++;
-        c = input[pos];
+void LispReader::fail_at_end(const std::string& message) {
+    /* the newline ending the input is not part of the form */
+    const size_t length = _position - (_after_newline ? 1 : 0);
+    _open = 0;
+    throw std::invalid_argument(error_message(length + 2, message, true));
+}
+
+
+#ifdef LISP_SSE2_LEXER
+// Lanes of chunk whose byte is within [low, high]; bytes past 0x7f never are.
+inline __m128i in_range(__m128i chunk, char low, char high) {
+    return _mm_and_si128(
+        _mm_cmpgt_epi8(chunk, _mm_set1_epi8(low - 1)),
+        _mm_cmplt_epi8(chunk, _mm_set1_epi8(high + 1))
+    );
+}
+
+// Past the first short_run bytes of characters of character_class, or the end of that run
+// when it is shorter. Most runs are, and a vector pass costs more than the few table lookups
+// they take.
+inline const char* scan_short_run(const char* begin, const char* end, unsigned char character_class) {
+    const char* short_end = end - begin > short_run ? begin + short_run : end;
+    while (begin != short_end && character_table.is(*begin, character_class)) begin++;
+    return begin;
+}
+#endif
+
+inline const char* scan_blanks(const char* begin, const char* end) {
+#ifdef LISP_SSE2_LEXER
+    begin = scan_short_run(begin, end, LispCharacterTable::blank);
+    if (begin == end || !character_table.is(*begin, LispCharacterTable::blank)) return begin;
+    for (; end - begin >= 16; begin += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        const __m128i blanks = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\f')))
+        );
+        const int others = _mm_movemask_epi8(blanks) ^ 0xffff;
+        if (others) return begin + __builtin_ctz(others);
+    }
+#endif
+    while (begin != end && character_table.is(*begin, LispCharacterTable::blank)) begin++;
+    return begin;
+}
+
+inline const char* scan_atom(const char* begin, const char* end) {
+#ifdef LISP_SSE2_LEXER
+    static const char punctuations[] = "_+-*/%^=<>&|!";
+    begin = scan_short_run(begin, end, LispCharacterTable::atom);
+    if (begin == end || !character_table.is(*begin, LispCharacterTable::atom)) return begin;
+    for (; end - begin >= 16; begin += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i atoms = _mm_or_si128(
+            in_range(_mm_or_si128(chunk, _mm_set1_epi8(0x20)), 'a', 'z'),
+            in_range(chunk, '0', '9')
+        );
+        for (const char* punctuation = punctuations; *punctuation; punctuation++) {
+            atoms = _mm_or_si128(atoms, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(*punctuation)));
+        }
+        const int others = _mm_movemask_epi8(atoms) ^ 0xffff;
+        if (others) return begin + __builtin_ctz(others);
     }
+#endif
+    while (begin != end && character_table.is(*begin, LispCharacterTable::atom)) begin++;
+    return begin;
 }
 
 inline std::string error_message(size_t pos, const std::string& message, bool is_end) {
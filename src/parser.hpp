@@ -2,10 +2,78 @@
 #define _PARSER_HPP_
 
 
+#include <istream>
 #include <string>
+#include <vector>
 #include "lispvalue.hpp"
+#include "mappedfile.hpp"
 
 
 LispValue parse(const std::string& input);
 
+// Reads top-level forms one at a time from a stream, holding no more than the current form.
+// A form is one line, continued over the following lines while a bracket or a string is
+// still open, and reads as an S-Expression. Nesting is handled without recursion.
+class LispReader {
+    public:
+        LispReader(std::istream& input);
+        // reads the bytes of file in place, taking over one reference to it
+        LispReader(LispMappedFile* file);
+        ~LispReader();
+
+        LispReader(const LispReader&) = delete;
+        LispReader& operator=(const LispReader&) = delete;
+
+        // Reads the next form; returns false at the end of input. On a syntax error the rest
+        // of the form is skipped before throwing, so that reading resumes at the next form.
+        bool read(LispValue& form);
+
+        // line the last form read starts at, counting from 1
+        size_t form_line() const { return _form_line; }
+
+    private:
+        static const int end_of_input = std::char_traits<char>::eof();
+
+        struct Frame {
+            LispType type;
+            char rparen;
+            std::vector<LispValue> cells;
+        };
+
+        std::streambuf* const _input;
+        LispMappedFile* const _mapping;
+        std::vector<char> _buffer;      // characters taken from _input, scanned in place
+        const char* _cursor;
+        const char* _end;
+        std::vector<Frame> _frames;     // frames past _open keep their storage for reuse
+        size_t _open;
+        std::string _atom;
+        size_t _line;
+        size_t _form_line;
+        size_t _position;       // characters of the current form consumed so far
+        bool _after_newline;
+        int _depth;             // open brackets, counted the way form ends are found
+
+        int peek() {
+            return _cursor != _end || refill() ? static_cast<unsigned char>(*_cursor) : end_of_input;
+        }
+        int get();
+        bool refill();
+        // consumes n characters before _end, none of which is a newline
+        void advance(size_t n) {
+            _cursor += n;
+            _position += n;
+            _after_newline = false;
+        }
+
+        void read_atom();
+        // appends the run of atom characters at _cursor to _atom
+        void append_atom();
+        void read_string();
+        void open_frame(char lparen);
+        void close_frame();
+        [[noreturn]] void fail(size_t pos, const std::string& message);
+        [[noreturn]] void fail_at_end(const std::string& message);
+};
+
 #endif  // _PARSER_HPP_
@@ -0,0 +1,209 @@
+#include "pool.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+static const size_t granularity = 16;
+static const size_t num_classes = 16;
+static const size_t chunk_size = 64 * 1024;
+
+struct LispFreeBlock {
+    LispFreeBlock* next;
+};
+
+// Free lists, chunk and counts of one thread, so that allocation takes no lock; blocks may be
+// returned by another thread than the one that took them, and then join its free lists.
+struct LispPoolCache {
+    LispFreeBlock* free_lists[num_classes];
+    char* chunk_cursor;
+    char* chunk_end;
+    size_t bytes_in_use, objects_in_use, peak_bytes, reserved_bytes;
+    size_t allocation_count;
+};
+
+/* plain thread data, so that objects released during static destruction still find it */
+static thread_local LispPoolCache cache;
+
+/* counts folded in from the caches, which on their own may well wrap below zero */
+static std::atomic<size_t> folded_bytes(0), folded_objects(0), folded_peak(0), folded_reserved(0);
+
+// Free blocks and chunk room left by threads that have ended, such as the ones of isolates,
+// for the threads after them to take over instead of reserving more.
+struct LispPoolSpares {
+    std::mutex mutex;
+    LispFreeBlock* free_lists[num_classes];
+    std::vector<std::pair<char*, char*>> chunks;
+};
+
+
+// Hands the cache of a thread over to the spares when the thread ends.
+struct LispPoolReturn {
+    bool is_armed;
+    ~LispPoolReturn();
+};
+
+static thread_local LispPoolReturn pool_return;
+
+
+inline size_t size_class_of(size_t size);
+inline void note_peak();
+inline void refill(LispPoolCache& local, size_t size_class);
+inline LispPoolSpares& pool_spares();
+
+
+void* LispPool::allocate(size_t size) {
+    LispPoolCache& local(cache);
+    const size_t size_class = size_class_of(size);
+    if (size_class >= num_classes) {
+        /* large objects are rare enough to go to the heap */
+        void* pointer = ::operator new(size);
+        local.objects_in_use++;
+        local.bytes_in_use += size;
+        note_peak();
+        return pointer;
+    }
+
+    const size_t block_size = (size_class + 1) * granularity;
+    void* pointer;
+    if (local.free_lists[size_class]) {
+        pointer = local.free_lists[size_class];
+        local.free_lists[size_class] = local.free_lists[size_class]->next;
+    } else {
+        if (local.chunk_cursor + block_size > local.chunk_end) refill(local, size_class);
+        if (local.free_lists[size_class]) {
+            pointer = local.free_lists[size_class];
+            local.free_lists[size_class] = local.free_lists[size_class]->next;
+        } else {
+            pointer = local.chunk_cursor;
+            local.chunk_cursor += block_size;
+        }
+    }
+
+    local.allocation_count++;
+    local.objects_in_use++;
+    local.bytes_in_use += block_size;
+    note_peak();
+    return pointer;
+}
+
+void LispPool::deallocate(void* pointer, size_t size) {
+    if (!pointer) return;
+
+    LispPoolCache& local(cache);
+    const size_t size_class = size_class_of(size);
+    local.objects_in_use--;
+    if (size_class >= num_classes) {
+        local.bytes_in_use -= size;
+        ::operator delete(pointer);
+        return;
+    }
+
+    local.bytes_in_use -= (size_class + 1) * granularity;
+    LispFreeBlock* block = static_cast<LispFreeBlock*>(pointer);
+    block->next = local.free_lists[size_class];
+    local.free_lists[size_class] = block;
+}
+
+void LispPool::fold_thread_counts() {
+    LispPoolCache& local(cache);
+    folded_bytes += local.bytes_in_use;
+    folded_objects += local.objects_in_use;
+    folded_reserved += local.reserved_bytes;
+    size_t peak = folded_peak.load();
+    while (peak < local.peak_bytes && !folded_peak.compare_exchange_weak(peak, local.peak_bytes)) {}
+    local.bytes_in_use = local.objects_in_use = local.reserved_bytes = local.peak_bytes = 0;
+}
+
+size_t LispPool::bytes() {
+    return folded_bytes.load() + cache.bytes_in_use;
+}
+
+size_t LispPool::live() {
+    return folded_objects.load() + cache.objects_in_use;
+}
+
+size_t LispPool::peak() {
+    const size_t peak = folded_peak.load();
+    return peak < cache.peak_bytes ? cache.peak_bytes : peak;
+}
+
+size_t LispPool::reserved() {
+    return folded_reserved.load() + cache.reserved_bytes;
+}
+
+size_t LispPool::thread_allocations() {
+    return cache.allocation_count;
+}
+
+
+inline size_t size_class_of(size_t size) {
+    return size ? (size - 1) / granularity : 0;
+}
+
+// Peak as seen by this thread: what the others have folded in, with its own count on top.
+inline void note_peak() {
+    LispPoolCache& local(cache);
+    const size_t bytes = folded_bytes.load(std::memory_order_relaxed) + local.bytes_in_use;
+    if (local.peak_bytes < bytes) local.peak_bytes = bytes;
+}
+
+// Takes over the spare blocks of the size class, or else spare chunk room, or else a new chunk.
+inline void refill(LispPoolCache& local, size_t size_class) {
+    pool_return.is_armed = true;
+    {
+        LispPoolSpares& spares(pool_spares());
+        std::lock_guard<std::mutex> lock(spares.mutex);
+        if (spares.free_lists[size_class]) {
+            local.free_lists[size_class] = spares.free_lists[size_class];
+            spares.free_lists[size_class] = nullptr;
+            return;
+        }
+        const size_t block_size = (size_class + 1) * granularity;
+        while (!spares.chunks.empty()) {
+            const std::pair<char*, char*> room = spares.chunks.back();
+            spares.chunks.pop_back();
+            if (room.first + block_size > room.second) continue;
+            local.chunk_cursor = room.first;
+            local.chunk_end = room.second;
+            return;
+        }
+    }
+
+    /* the tail of the previous chunk is abandoned */
+    local.chunk_cursor = static_cast<char*>(::operator new(chunk_size));
+    local.chunk_end = local.chunk_cursor + chunk_size;
+    local.reserved_bytes += chunk_size;
+}
+
+LispPoolReturn::~LispPoolReturn() {
+    LispPoolCache& local(cache);
+    {
+        LispPoolSpares& spares(pool_spares());
+        std::lock_guard<std::mutex> lock(spares.mutex);
+        for (size_t size_class = 0; size_class < num_classes; size_class++) {
+            /* the spare list goes after the last block of this one */
+            LispFreeBlock* list = local.free_lists[size_class];
+            if (!list) continue;
+            LispFreeBlock* last = list;
+            while (last->next) last = last->next;
+            last->next = spares.free_lists[size_class];
+            spares.free_lists[size_class] = list;
+            local.free_lists[size_class] = nullptr;
+        }
+        if (local.chunk_cursor != local.chunk_end) {
+            spares.chunks.push_back(std::make_pair(local.chunk_cursor, local.chunk_end));
+        }
+        local.chunk_cursor = local.chunk_end = nullptr;
+    }
+    LispPool::fold_thread_counts();
+}
+
+inline LispPoolSpares& pool_spares() {
+    /* never destroyed, since threads may still end during static destruction */
+    static LispPoolSpares* spares = new LispPoolSpares();
+    return *spares;
+}
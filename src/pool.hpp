@@ -0,0 +1,58 @@
+#ifndef _POOL_HPP_
+#define _POOL_HPP_
+
+
+#include <cstddef>
+
+
+// Free-list allocator for the small objects of the evaluator, in size classes of 16 bytes.
+// Blocks are carved from 64 KiB chunks and recycled, never returned to the system.
+// Every thread has free lists and counts of its own; the counts below are those folded in by
+// the threads of LispThreadPool after their tasks, plus those of the calling thread.
+class LispPool {
+    public:
+        static void* allocate(size_t size);
+        static void deallocate(void* pointer, size_t size);
+
+        // adds the counts of the calling thread to the totals
+        static void fold_thread_counts();
+
+        static size_t bytes();      // bytes handed out and not yet returned
+        static size_t live();       // objects handed out and not yet returned
+        static size_t peak();       // highest value of bytes so far, as seen by single threads
+        static size_t reserved();   // bytes taken from the system for chunks
+
+        // blocks handed out to the calling thread since it started, never folded; larger objects
+        // are heap allocations
+        static size_t thread_allocations();
+};
+
+// Standard allocator over LispPool, for allocate_shared.
+template<typename T>
+class LispPoolAllocator {
+    public:
+        typedef T value_type;
+
+        LispPoolAllocator() {}
+        template<typename U>
+        LispPoolAllocator(const LispPoolAllocator<U>&) {}
+
+        T* allocate(size_t n) {
+            return static_cast<T*>(LispPool::allocate(n * sizeof(T)));
+        }
+        void deallocate(T* pointer, size_t n) {
+            LispPool::deallocate(pointer, n * sizeof(T));
+        }
+};
+
+template<typename T, typename U>
+inline bool operator==(const LispPoolAllocator<T>&, const LispPoolAllocator<U>&) {
+    return true;
+}
+
+template<typename T, typename U>
+inline bool operator!=(const LispPoolAllocator<T>&, const LispPoolAllocator<U>&) {
+    return false;
+}
+
+#endif  // _POOL_HPP_
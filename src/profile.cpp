@@ -0,0 +1,301 @@
+#include "profile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "allocation.hpp"
+#include "pool.hpp"
+
+
+static const size_t none = static_cast<size_t>(-1);
+
+// Counts of one function. Lambda functions are told apart by scope, so that partial applications
+// and memoized copies count as the function they were made of, and built-in ones by symbol.
+struct LispFunctionProfile {
+    uint64_t key;
+    size_t calls;
+    size_t active;                      // frames on the stack, so that recursion counts once
+    uint64_t inclusive_time;            // nanoseconds
+    uint64_t exclusive_time;
+    size_t inclusive_allocations;
+    size_t exclusive_allocations;
+};
+
+// Function called by the stack of the nodes above, with the time it spent itself there.
+struct LispStackNode {
+    size_t function;
+    std::vector<size_t> children;
+    uint64_t exclusive_time;
+};
+
+struct LispCallFrame {
+    size_t node;
+    size_t start_allocations;
+    uint64_t start_time;
+    uint64_t child_time;
+    size_t child_allocations;
+};
+
+// Functions and tree of stacks of one thread, or the totals folded in from threads; node 0 is
+// the root of the tree.
+struct LispProfileData {
+    std::vector<LispFunctionProfile> functions;
+    std::unordered_map<uint64_t, size_t> indices;
+    std::vector<LispStackNode> nodes;
+
+    LispProfileData(): functions(), indices(), nodes(1, LispStackNode{ none, std::vector<size_t>(), 0 }) {}
+};
+
+bool LispProfiler::_is_enabled = false;
+
+static thread_local LispProfileData thread_profile;
+static thread_local std::vector<LispCallFrame> frames;
+static thread_local size_t expected_function = none;   // lambda function whose body comes next
+
+static std::mutex totals_mutex;
+static LispProfileData totals;
+
+/* a lambda function takes the first name it is defined as, else the one made of its parameters */
+static std::mutex names_mutex;
+static std::unordered_map<uint64_t, std::string> defined_names;
+static std::unordered_map<uint64_t, std::string> anonymous_names;
+
+
+inline uint64_t lambda_key(const LispValue& function);
+inline uint64_t builtin_key(const LispValue& function);
+inline uint64_t now();
+inline size_t allocations();
+inline size_t function_index(LispProfileData& data, uint64_t key);
+inline size_t child_node(LispProfileData& data, size_t parent, size_t function);
+inline void enter(size_t function);
+inline void merge(const LispProfileData& from, LispProfileData& into);
+inline std::string function_name(uint64_t key);
+inline void write_stacks(std::ostream& stacks, const std::vector<std::string>& names);
+
+
+void LispProfiler::enable() {
+    _is_enabled = true;
+}
+
+void LispProfiler::name(const LispValue& function, int symbol_id) {
+    if (!_is_enabled || function.type != LispType::LambdaFunction) return;
+    std::lock_guard<std::mutex> lock(names_mutex);
+    defined_names.emplace(lambda_key(function), LispSymbolTable::name(symbol_id));
+}
+
+void LispProfiler::expect_call(const LispValue& function) {
+    const uint64_t key = lambda_key(function);
+    if (!thread_profile.indices.count(key)) {
+        std::ostringstream params;
+        params << "lambda " << function.params();
+        std::lock_guard<std::mutex> lock(names_mutex);
+        anonymous_names.emplace(key, params.str());
+    }
+    expected_function = function_index(thread_profile, key);
+}
+
+void LispProfiler::end_call() {
+    if (expected_function == none) return;
+    enter(expected_function);
+    leave();
+}
+
+void LispProfiler::fold_thread_profile() {
+    if (!_is_enabled || !frames.empty() || expected_function != none) return;
+    std::lock_guard<std::mutex> lock(totals_mutex);
+    merge(thread_profile, totals);
+    thread_profile = LispProfileData();
+}
+
+void LispProfiler::report(std::ostream& profile, std::ostream& stacks) {
+    fold_thread_profile();
+    std::lock_guard<std::mutex> lock(totals_mutex);
+
+    std::vector<std::string> names;
+    uint64_t total_time = 0;
+    size_t total_calls = 0;
+    std::vector<const LispFunctionProfile*> sorted;
+    for (const LispFunctionProfile& function : totals.functions) {
+        names.push_back(function_name(function.key));
+        total_time += function.exclusive_time;
+        total_calls += function.calls;
+        sorted.push_back(&function);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const LispFunctionProfile* x, const LispFunctionProfile* y) {
+        return x->exclusive_time > y->exclusive_time;
+    });
+
+    profile << "profile: " << std::fixed << std::setprecision(6) << total_time / 1e9 << "s in "
+        << total_calls << " calls" << std::endl;
+    profile << std::setw(12) << "calls" << std::setw(14) << "inclusive" << std::setw(14) << "exclusive"
+        << std::setw(8) << "%" << std::setw(14) << "allocations" << std::setw(14) << "exclusive"
+        << "  function" << std::endl;
+    for (const LispFunctionProfile* function : sorted) {
+        profile << std::setw(12) << function->calls
+            << std::setw(14) << std::setprecision(6) << function->inclusive_time / 1e9
+            << std::setw(14) << function->exclusive_time / 1e9
+            << std::setw(8) << std::setprecision(2)
+            << (total_time ? 100.0 * function->exclusive_time / total_time : 0.0)
+            << std::setw(14) << function->inclusive_allocations
+            << std::setw(14) << function->exclusive_allocations
+            << "  " << names[function - totals.functions.data()] << std::endl;
+    }
+
+    write_stacks(stacks, names);
+}
+
+size_t LispProfiler::begin_scope() {
+    const size_t base = frames.size();
+    if (expected_function != none) enter(expected_function);
+    return base;
+}
+
+void LispProfiler::continue_scope(size_t base) {
+    if (expected_function == none) return;
+    while (frames.size() > base) leave();
+    enter(expected_function);
+}
+
+void LispProfiler::end_scope(size_t base) {
+    while (frames.size() > base) leave();
+}
+
+void LispProfiler::enter_builtin(const LispValue& function) {
+    enter(function_index(thread_profile, builtin_key(function)));
+}
+
+void LispProfiler::leave() {
+    const uint64_t end_time = now();
+    const size_t end_allocations = allocations();
+    const LispCallFrame frame(frames.back());
+    frames.pop_back();
+
+    const uint64_t time = end_time - frame.start_time;
+    const size_t allocated = end_allocations - frame.start_allocations;
+    LispStackNode& node(thread_profile.nodes[frame.node]);
+    LispFunctionProfile& function(thread_profile.functions[node.function]);
+    node.exclusive_time += time - frame.child_time;
+    function.exclusive_time += time - frame.child_time;
+    function.exclusive_allocations += allocated - frame.child_allocations;
+    if (--function.active == 0) {
+        function.inclusive_time += time;
+        function.inclusive_allocations += allocated;
+    }
+    if (!frames.empty()) {
+        frames.back().child_time += time;
+        frames.back().child_allocations += allocated;
+    }
+}
+
+
+inline uint64_t lambda_key(const LispValue& function) {
+    return static_cast<uint64_t>(function.scope()) << 1 | 1;
+}
+
+inline uint64_t builtin_key(const LispValue& function) {
+    return static_cast<uint64_t>(function.symbol_id()) << 1;
+}
+
+inline uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline size_t allocations() {
+    return thread_heap_allocations() + LispPool::thread_allocations();
+}
+
+inline size_t function_index(LispProfileData& data, uint64_t key) {
+    auto itr = data.indices.find(key);
+    if (itr != data.indices.end()) return itr->second;
+    data.functions.push_back(LispFunctionProfile{ key, 0, 0, 0, 0, 0, 0 });
+    data.indices.emplace(key, data.functions.size() - 1);
+    return data.functions.size() - 1;
+}
+
+inline size_t child_node(LispProfileData& data, size_t parent, size_t function) {
+    for (size_t child : data.nodes[parent].children) {
+        if (data.nodes[child].function == function) return child;
+    }
+    data.nodes.push_back(LispStackNode{ function, std::vector<size_t>(), 0 });
+    data.nodes[parent].children.push_back(data.nodes.size() - 1);
+    return data.nodes.size() - 1;
+}
+
+// Pushes the frame of function, timed from the moment it is pushed.
+inline void enter(size_t function) {
+    expected_function = none;
+    const size_t parent = frames.empty() ? 0 : frames.back().node;
+    const size_t node = child_node(thread_profile, parent, function);
+    thread_profile.functions[function].calls++;
+    thread_profile.functions[function].active++;
+    frames.push_back(LispCallFrame{ node, allocations(), 0, 0, 0 });
+    frames.back().start_time = now();
+}
+
+inline void merge(const LispProfileData& from, LispProfileData& into) {
+    std::vector<size_t> functions;
+    for (const LispFunctionProfile& function : from.functions) {
+        const size_t index = function_index(into, function.key);
+        LispFunctionProfile& total(into.functions[index]);
+        total.calls += function.calls;
+        total.inclusive_time += function.inclusive_time;
+        total.exclusive_time += function.exclusive_time;
+        total.inclusive_allocations += function.inclusive_allocations;
+        total.exclusive_allocations += function.exclusive_allocations;
+        functions.push_back(index);
+    }
+
+    /* nodes of from paired with the nodes of into for the same stacks */
+    std::vector<std::pair<size_t, size_t>> pending{ { 0, 0 } };
+    while (!pending.empty()) {
+        const std::pair<size_t, size_t> nodes(pending.back());
+        pending.pop_back();
+        for (size_t child : from.nodes[nodes.first].children) {
+            const size_t total = child_node(into, nodes.second, functions[from.nodes[child].function]);
+            into.nodes[total].exclusive_time += from.nodes[child].exclusive_time;
+            pending.push_back({ child, total });
+        }
+    }
+}
+
+inline std::string function_name(uint64_t key) {
+    if (!(key & 1)) return LispSymbolTable::name(static_cast<int>(key >> 1));
+    std::lock_guard<std::mutex> lock(names_mutex);
+    auto itr = defined_names.find(key);
+    if (itr != defined_names.end()) return itr->second;
+    itr = anonymous_names.find(key);
+    return itr != anonymous_names.end() ? itr->second : "lambda";
+}
+
+// Every stack whose last function spent a microsecond or more itself, as "f;g;h microseconds".
+inline void write_stacks(std::ostream& stacks, const std::vector<std::string>& names) {
+    std::vector<std::pair<size_t, size_t>> pending;     // node and its depth
+    std::vector<const std::string*> path;
+    for (size_t child : totals.nodes[0].children) pending.push_back({ child, 0 });
+    while (!pending.empty()) {
+        const std::pair<size_t, size_t> next(pending.back());
+        pending.pop_back();
+        const LispStackNode& node(totals.nodes[next.first]);
+        path.resize(next.second);
+        path.push_back(&names[node.function]);
+
+        const uint64_t microseconds = node.exclusive_time / 1000;
+        if (microseconds != 0) {
+            for (size_t index = 0; index < path.size(); index++) {
+                if (index != 0) stacks << ';';
+                stacks << *path[index];
+            }
+            stacks << ' ' << microseconds << '\n';
+        }
+        for (size_t child : node.children) pending.push_back({ child, next.second + 1 });
+    }
+    stacks.flush();
+}
@@ -0,0 +1,86 @@
+#ifndef _PROFILE_HPP_
+#define _PROFILE_HPP_
+
+
+#include <cstddef>
+#include <ostream>
+#include "lispvalue.hpp"
+
+
+// Calls, time and allocations of every function, for --profile.
+// Every call in progress has a frame: a built-in function for as long as it runs, a lambda
+// function from the start of its body to its end. A tail call replaces the frame of the lambda
+// function making it, just as it replaces the C++ frame, so loops leave flat stacks. Threads
+// profile on their own and fold their counts in after each task; tasks taken by other threads
+// start stacks of their own.
+class LispProfiler {
+    public:
+        // only before anything is evaluated
+        static void enable();
+        static bool is_enabled() { return _is_enabled; }
+
+        // names a lambda function after the first symbol it is defined as, not its parameters
+        static void name(const LispValue& function, int symbol_id);
+
+        // Call of a lambda function about to be made. The LispProfileScope evaluating its body
+        // enters its frame; a call that ends without one, such as a partial application, counts
+        // as taking no time.
+        static void expect_call(const LispValue& function);
+        static void end_call();
+
+        // adds the counts of the calling thread to the totals, unless it is inside a call
+        static void fold_thread_profile();
+
+        // Writes the functions by exclusive time to profile, and the stacks of calls with their
+        // exclusive microseconds to stacks, one per line as flame graph tools read them.
+        static void report(std::ostream& profile, std::ostream& stacks);
+
+    private:
+        static bool _is_enabled;
+
+        static size_t begin_scope();
+        static void continue_scope(size_t base);
+        static void end_scope(size_t base);
+        static void enter_builtin(const LispValue& function);
+        static void leave();
+
+        friend class LispProfileScope;
+        friend class LispProfileFrame;
+};
+
+// Frames entered while evaluating one expression, which are left along with it.
+class LispProfileScope {
+    public:
+        LispProfileScope():
+        _is_profiled(LispProfiler::is_enabled()),
+        _base(_is_profiled ? LispProfiler::begin_scope() : 0)
+        {}
+
+        ~LispProfileScope() {
+            if (_is_profiled) LispProfiler::end_scope(_base);
+        }
+
+        LispProfileScope(const LispProfileScope&) = delete;
+        LispProfileScope& operator=(const LispProfileScope&) = delete;
+
+        // after taking over a tail call, whose body continues in this scope
+        void tail_call() {
+            if (_is_profiled) LispProfiler::continue_scope(_base);
+        }
+
+    private:
+        const bool _is_profiled;
+        const size_t _base;
+};
+
+// Frame of a built-in function while it runs, only made when profiling.
+class LispProfileFrame {
+    public:
+        explicit LispProfileFrame(const LispValue& function) { LispProfiler::enter_builtin(function); }
+        ~LispProfileFrame() { LispProfiler::leave(); }
+
+        LispProfileFrame(const LispProfileFrame&) = delete;
+        LispProfileFrame& operator=(const LispProfileFrame&) = delete;
+};
+
+#endif  // _PROFILE_HPP_
@@ -0,0 +1,71 @@
+#include "script.hpp"
+
+#include <fstream>
+#include <ostream>
+#include "evaluation.hpp"
+#include "gc.hpp"
+#include "parser.hpp"
+
+
+inline void load_forms(
+    LispReader& reader,
+    const std::string& path,
+    const std::shared_ptr<LispEnvironment>& environment
+);
+
+
+size_t run_script(LispReader& reader, const std::shared_ptr<LispEnvironment>& environment) {
+    size_t failed = 0;
+    while (true) {
+        LispValue value;
+        try {
+            if (!reader.read(value)) break;
+            value = evaluate(value, environment);
+        } catch (const std::exception& exception) {
+            environment->errors() << exception.what() << std::endl;
+            failed++;
+            continue;
+        }
+        if (value.type != LispType::Unit) {
+            environment->output() << value << std::endl;
+        }
+        value = LispValue();
+        environment->collector().collect_if_needed();
+    }
+    return failed;
+}
+
+void load_script(const std::string& path, const std::shared_ptr<LispEnvironment>& environment) {
+    LispMappedFile* file = LispMappedFile::open(path);
+    if (file) {
+        LispReader reader(file);
+        load_forms(reader, path, environment);
+        return;
+    }
+
+    std::ifstream input(path);
+    if (!input) {
+        throw std::invalid_argument("Error: cannot open file " + path);
+    }
+    LispReader reader(input);
+    load_forms(reader, path, environment);
+}
+
+
+inline void load_forms(
+    LispReader& reader,
+    const std::string& path,
+    const std::shared_ptr<LispEnvironment>& environment
+) {
+    while (true) {
+        try {
+            LispValue value;
+            if (!reader.read(value)) break;
+            evaluate(value, environment);
+        } catch (const std::exception& exception) {
+            throw std::invalid_argument(
+                path + ":" + std::to_string(reader.form_line()) + ": " + exception.what());
+        }
+    }
+}
+
@@ -0,0 +1,19 @@
+#ifndef _SCRIPT_HPP_
+#define _SCRIPT_HPP_
+
+
+#include <string>
+#include "lispvalue.hpp"
+#include "parser.hpp"
+
+
+// Evaluates every form of reader at top level, printing results and errors like the REPL,
+// to the sinks of the environment.
+// Returns the number of forms that failed.
+size_t run_script(LispReader& reader, const std::shared_ptr<LispEnvironment>& environment);
+
+// Evaluates every form of the file at path, stopping at the first error.
+// The file is read in place from a memory mapping when it can be mapped.
+void load_script(const std::string& path, const std::shared_ptr<LispEnvironment>& environment);
+
+#endif  // _SCRIPT_HPP_
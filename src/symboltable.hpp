@@ -0,0 +1,62 @@
+#ifndef _SYMBOLTABLE_HPP_
+#define _SYMBOLTABLE_HPP_
+
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+#include <unordered_map>
+
+
+// Interns symbol names so that symbols are compared and hashed as integer ids.
+// Interning takes a lock, as parallel tasks may intern too; names are kept in chunks that
+// never move, so that looking one up takes none.
+class LispSymbolTable {
+    public:
+        static int intern(const std::string& name) {
+            LispSymbolTable& table(instance());
+            std::lock_guard<std::mutex> lock(table._mutex);
+            symbols_itr itr = table._ids.find(name);
+            if (itr != table._ids.end()) return itr->second;
+
+            const size_t id = table._size.load(std::memory_order_relaxed);
+            if (id >= num_chunks * chunk_size) throw std::length_error("Error: too many symbols");
+            const std::string**& chunk(table._chunks[id / chunk_size]);
+            if (!chunk) chunk = new const std::string*[chunk_size];
+            itr = table._ids.emplace(name, static_cast<int>(id)).first;
+            chunk[id % chunk_size] = &itr->first;
+            table._size.store(id + 1, std::memory_order_release);
+            return static_cast<int>(id);
+        }
+
+        static const std::string& name(int id) {
+            return *instance()._chunks[id / chunk_size][id % chunk_size];
+        }
+
+        static size_t size() {
+            return instance()._size.load(std::memory_order_acquire);
+        }
+
+    private:
+        using symbols_itr = std::unordered_map<std::string, int>::const_iterator;
+
+        static const size_t chunk_size = 4096;
+        static const size_t num_chunks = 4096;
+
+        /* keys of an unordered_map never move, so the chunks can point to them */
+        std::mutex _mutex;
+        std::unordered_map<std::string, int> _ids;
+        const std::string** _chunks[num_chunks];
+        std::atomic<size_t> _size;
+
+        LispSymbolTable(): _mutex(), _ids(), _chunks(), _size(0) {}
+
+        static LispSymbolTable& instance() {
+            /* never destroyed, since names may still be looked up during static destruction */
+            static LispSymbolTable* table = new LispSymbolTable();
+            return *table;
+        }
+};
+
+#endif  // _SYMBOLTABLE_HPP_
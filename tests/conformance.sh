@@ -0,0 +1,30 @@
+#!/bin/sh
+# Runs every script of the conformance corpus with the tree walker and with --bytecode, and
+# fails when either engine prints anything, errors included, other than the script's .out file,
+# so that a bug both engines share is caught as well as one where they differ.
+# usage: tests/conformance.sh [lisp.out]
+
+LISP=${1:-build/lisp.out}
+CORPUS=$(dirname "$0")/conformance
+TMP=${TMPDIR:-/tmp}/conformance.$$
+mkdir -p "$TMP" || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+failed=0
+for script in "$CORPUS"/*.lisp; do
+    name=$(basename "$script" .lisp)
+    for engine in "" --bytecode; do
+        label=${engine:-tree}
+        label=${label#--}
+        "$LISP" $engine "$script" > "$TMP/$name.$label" 2>&1 < /dev/null
+        if diff -u "$CORPUS/$name.out" "$TMP/$name.$label" > "$TMP/$name.diff"; then
+            echo "ok      $name $label"
+        else
+            echo "FAILED  $name $label"
+            cat "$TMP/$name.diff"
+            failed=$((failed + 1))
+        fi
+    done
+done
+
+[ "$failed" -eq 0 ] || { echo "$failed of the runs differ from their expected output"; exit 1; }
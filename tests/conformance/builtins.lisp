@@ -0,0 +1,120 @@
++ 1 2 3
+- 5
+- 10 3 2
+* 2 3 4
+/ 20 3
+% 20 3
+^ 2 10
++ 2147483647 1
+/ 1 0
+list 1 2 "a" {b c}
+head {1 2 3}
+tail {1 2 3}
+head "hello"
+tail "hello"
+cons 0 {1 2}
+join {1 2} {3} {} {4 5}
+join "ab" "cd"
+len {1 2 3}
+len "abcd"
+eval {+ 1 2}
+eval {head {4 5}}
+if true {+ 1 1} {+ 2 2}
+if false {+ 1 1} {+ 2 2}
+if false {1}
+cond {(> 1 2) {1}} {(< 1 2) {2}}
+cond {false {1}} {otherwise {3}}
+case 2 {1 {"one"}} {2 {"two"}} {otherwise {"other"}}
+case 5 {1 {"one"}} {otherwise {"other"}}
+case "x" {"x" {"ex"}}
+when true {1} {2}
+unless true {1} {2}
+unless false {1} {2}
+&& 1 0
+|| 1 0
+! 0
+== {1 2} {1 2}
+!= 1 2
+== "a" "a"
+> 3 2 1
+>= 3 3 1
+< 1 2 3
+<= 1 1
+<= 1 2
+def {x y} 10 20
++ x y
+defun {add a b} {+ a b}
+add 3 4
+add 3
+(add 3) 5
+def {add5} (add 5)
+add5 10
+add5
+lambda {a b} {* a b}
+(lambda {a b} {* a b}) 6 7
+defun {fact n} {if (<= n 1) {1} {* n (fact (- n 1))}}
+defun {fact n} {if (== n 0) {1} {* n (fact (- n 1))}}
+fact 10
+defun {fib n} {if (< n 2) {n} {+ (fib (- n 1)) (fib (- n 2))}}
+fib 15
+defun {unit-f} {+ 1 2}
+unit-f ()
+unit-f
+do {print "a"} {print 1 2} {+ 1 1}
+type 1
+type "s"
+type {1}
+type +
+type add
+type ()
+type x
+def {+} 1
+del {x}
+x
+del {y}
+y
+def {z} {1 2 3}
+head z
+z
+tail z
+z
+defun {len2 l} {if (== l {}) {0} {+ 1 (len2 (tail l))}}
+len2 {1 2 3 4 5 6}
+defun {map f l} {if (== l nil) {nil} {cons (f (eval (head l))) (map f (tail l))}}
+map (lambda {x} {* x x}) {1 2 3 4}
+defun {sum l} {if (== l nil) {0} {+ (eval (head l)) (sum (tail l))}}
+sum {1 2 3 4 5}
+def {lst} (list 1 2 3)
+eval (head lst)
+head {(+ 1 2)}
+eval (head {(+ 1 2)})
+defun {foo} {x}
+(lambda {} {5}) ()
+1 2
+foo "bar"
+"str"
+unit
+nil
+{}
+()
+defun {adder x} {lambda {y} {+ x y}}
+def {a3} (adder 3)
+a3 4
+defun {compose f g x} {f (g x)}
+compose a3 a3 1
+defun {counter n} {if (== n 0) {0} {counter (- n 1)}}
+counter 1000
+== + +
+== a3 a3
+== (lambda {x} {x}) (lambda {x} {x})
+12abc
+-5
++5
+- -5
+{1 {2 3} "x" y}
+print "hi" {1 2} + a3
+"unterminated
+(+ 1
+def {q} 1 2
+lambda {true} {1}
+defun {g true} {1}
@@ -0,0 +1,18 @@
+(def {g} 1)
+(defun {f x} {+ x g})
+(print (f 1) (f 1))
+(def {g} 10)
+(print (f 1))
+(def {unrelated} 0)
+(print (f 1))
+(del {g})
+(def {g} 100)
+(print (f 1))
+(defun {redefine n} {if (== n 0) {f 0} {do {def {g} n} {redefine (- n 1)}}})
+(print (redefine 5))
+(defun {churn n} {if (== n 0) {f 0} {do {del {g}} {def {g} (* n 1000)} {print (f n)} {churn (- n 1)}}})
+(print (churn 3))
+(print (pmap f {1 2 3}))
+(del {g unrelated})
+(def {unrelated} 0)
+(f 1)
@@ -0,0 +1,34 @@
+defun {loop n acc} {if (== n 0) {acc} {loop (- n 1) (+ acc 1)}}
+loop 1000000 0
+defun {loopc n} {cond {(== n 0) {"done-cond"}} {otherwise {loopc (- n 1)}}}
+loopc 300000
+defun {loopk n} {case n {0 {"done-case"}} {otherwise {loopk (- n 1)}}}
+loopk 300000
+defun {loopd n} {do {+ 1 1} {if (== n 0) {"done-do"} {loopd (- n 1)}}}
+loopd 300000
+defun {loopu n} {unless (== n 0) {+ 1 1} {loopu (- n 1)}}
+loopu 300000
+defun {loopw n} {when (> n 0) {loopw (- n 1)}}
+loopw 300000
+defun {loope n} {if (== n 0) {"done-eval"} {eval {loope (- n 1)}}}
+loope 300000
+defun {even n} {if (== n 0) {true} {odd (- n 1)}}
+defun {odd n} {if (== n 0) {false} {even (- n 1)}}
+even 300001
+defun {loopp n} {if (== n 0) {"done-paren"} {(loopp (- n 1))}}
+loopp 300000
+defun {f a b c d e g h i j k x} {+ a b c d e g h i j k x}
+def {p} (((((((((f 1) 2) 3) 4) 5) 6) 7) 8) 9)
+def {q} (p 10)
+defun {loop n acc} {if (== n 0) {acc} {loop (- n 1) (+ acc (q n))}}
+loop 30000 0
+defun {ack m n} {cond {(== m 0) {+ n 1}} {(== n 0) {ack (- m 1) 1}} {otherwise {ack (- m 1) (ack m (- n 1))}}}
+ack 2 300
+ack 3 6
+defun {loop n acc} {if (== n 0) {acc} {loop (- n 1) (+ acc n)}}
+defun {rep k} {if (== k 0) {0} {do {loop 1000 0} {rep (- k 1)}}}
+rep 200
+def {x} 40
+(defun {f y}
+  {+ x y})
+f 2
@@ -0,0 +1,60 @@
+(print 1.5)
+(print -0.0)
+(print 3.)
+(print 1e5)
+(print 1E-7)
+(print 0.1)
+(print (+ 0.1 0.2))
+(print (+ 1 2.5))
+(print (- 10 0.5 0.25))
+(print (- 2.5))
+(print (* 1.5 4))
+(print (/ 7 2))
+(print (/ 7 2.0))
+(print (/ 1 0.0))
+(print (/ -1 0.0))
+(print (% 7.5 2))
+(print (% 1.0 0))
+(print (^ 2 0.5))
+(print (^ 2.0 -1))
+(print (^ 10.0 400))
+(print (+ 1.0 99999999999999999999999))
+(print (* 2.5 99999999999999999999999))
+(print (< 1 1.5 2))
+(print (< 1 1.0))
+(print (<= 1 1.0))
+(print (> 2147483648 2147483647.5))
+(print (>= 9007199254740993 9007199254740992.0))
+(print (> 9007199254740993 9007199254740992.0))
+(print (== 9007199254740992.0 9007199254740992.0))
+(print (< 1e400 99999999999999999999999999))
+(print (> 1e400 99999999999999999999999999))
+(print (< (/ 0.0 0.0) 1))
+(print (>= (/ 0.0 0.0) 1))
+(print (== 1.0 1.0))
+(print (== 1 1.0))
+(print (type 1.5))
+(print (sum {1 2.5 3}))
+(print (sum {1 2 3}))
+(print 1.7976931348623157e308)
+(print 5e-324)
+(print 123456789012345678.0)
+(print 0.000012)
+(print 0.0000012)
+(print {1.5 2.5})
+(def {x} 2.25)
+(print (* x x))
+(defun {avg xs} {/ (sum xs) (len xs)})
+(print (avg {1.5 2.5 3.0}))
+(print (&& 1.5 1))
+(print (! 1.5))
+(print 1.2.3)
+(print 1e)
+(print (+ 1.5 "a"))
+(print (+ [1 2] 1.5))
+(print (. 1))
+.5
+(print a.b)
+.
+-.5
+(print 1.5e+2 2.e3)
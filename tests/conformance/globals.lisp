@@ -0,0 +1,15 @@
+(defun {fib n} {if (< n 2) {n} {+ (fib (- n 1)) (fib (- n 2))}})
+(print (fib 20))
+(print (cache-stats ()))
+(def {k} 10)
+(defun {f x} {+ x k})
+(print (f 1))
+(def {k} 20)
+(print (f 1))
+(del {k})
+(f 1)
+(def {k} 30)
+(print (f 1))
+(defun {g x} {* x k})
+(print (cache-stats ()))
+(print (pmap g {1 2 3 4 5 6 7 8}))
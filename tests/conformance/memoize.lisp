@@ -0,0 +1,44 @@
+(defun {fib n} {if (< n 2) {n} {+ (fib (- n 1)) (fib (- n 2))}})
+(def {fib} (memoize fib))
+(print (fib 30))
+(print (memo-stats fib))
+(print (fib 30))
+(print (memo-stats fib))
+(def {small} (memoize (lambda {x} {* x x}) 2))
+(print (small 1) (small 2) (small 3) (small 1))
+(print (memo-stats small))
+(defun {keyed l s f} {len l})
+(def {keyed} (memoize keyed))
+(print (keyed {1 {2 3} "a"} "str" 1.5) (keyed {1 {2 3} "a"} "str" 1.5) (keyed {1 {2 3} "a"} "str" -0.0) (keyed {1 {2 3} "a"} "str" 0.0))
+(print (keyed [1 2 3] 99999999999999999999 'x') (keyed [1 2 3] 99999999999999999999 'x'))
+(print (memo-stats keyed))
+(def {add3} (memoize (lambda {a b c} {+ a b c})))
+(def {add1} (add3 1))
+(print (add1 2 3) (add3 1 2 3) ((add3 1 2) 3))
+(print (memo-stats add3) (memo-stats add1))
+(defun {mk x} {lambda {y} {+ x y}})
+(def {mk} (memoize mk))
+(def {f5} (mk 5))
+(gc-stats ())
+(print ((mk 5) 1) (== f5 (mk 5)))
+(print (pmap fib (range 0 20)))
+(print (memo-stats fib))
+memoize 1
+memoize fib 0
+memo-stats fib 1
+memo-stats (lambda {x} {x})
+(defun {boom x} {/ x 0})
+(def {boom} (memoize boom))
+boom 1
+print (memo-stats boom)
+print fib
+(defun {keyed a b} {len a})
+(def {keyed} (memoize keyed))
+(print (keyed (vector 1 2 3) 99999999999999999999) (keyed (vector 1 2 3) 99999999999999999999) (keyed (vector 1 2 4) 99999999999999999999))
+(print (memo-stats keyed))
+(defun {mk x} {lambda {y} {+ x y}})
+(def {mk} (memoize mk 10000))
+(len (map mk (to-list (range 0 6000))))
+(print (gc-stats ()))
+(print ((mk 7) 1) ((mk 5999) 1))
+(print (memo-stats mk))
@@ -0,0 +1,20 @@
+2147483647
+-2147483648
+2147483648
+-2147483649
++7
+007
+99999999999999999999999x
+(print (- -2147483648) (/ -2147483648 -1) (% -2147483648 -1) (^ 2 16) (^ 2 100) (type (^ 2 100)))
+(print (+ 2147483647 1) (- -2147483648 1) (+ 2147483647 1 -1) (type (+ 2147483647 1 -1)))
+(print 99999999999999999999999 -99999999999999999999999 (+ 99999999999999999999999 1))
+(print (== (^ 2 64) 18446744073709551616) (== (^ 2 31) 2147483648) (!= (^ 2 64) (^ 2 65)))
+(print (! (^ 2 40)) (&& (^ 2 40) 1) (|| 0 (^ 2 40)) (< 1 (^ 2 40) (^ 2 41)) (>= (^ 2 40) (^ 2 41)))
+(print (sum {2147483647 2147483647}) (dot (vector 2147483647 2147483647) (vector 2147483647 2147483647)) (sum (vector 2147483647 1)))
+(print (- (^ 2 100) (^ 2 100)) (type (- (^ 2 100) (^ 2 100))) (/ (^ 10 30) (^ 10 29)) (^ (^ 2 64) 0))
+(def {big} (* 123456789123456789 987654321987654321))
+(* (vector 65536) 65536)
+(^ 2 (^ 2 40))
+(^ 2 -1)
+(/ (^ 2 40) 0)
+(% 1 0)
@@ -0,0 +1,17 @@
++ 1 2) 3
+{1 2)
+(1 }
+}
+12abc
+99999999999
+  + 1 @ 2
+def {x} "multi
+line string"
+x
+(+ 1
+  2
+  (* 3 4))
+   
+  ( list 1 {2 (3)} () )
+print "a(b" {c}
++ 1 2)   
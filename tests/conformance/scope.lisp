@@ -0,0 +1,67 @@
+defun {adder x} {lambda {y} {+ x y}}
+((adder 3) 4)
+defun {curry3 a} {lambda {b} {lambda {c} {list a b c}}}
+(((curry3 1) 2) 3)
+defun {shadow x} {(lambda {x} {* x 10}) (+ x 1)}
+shadow 4
+def {g} 100
+defun {useg x} {+ x g}
+useg 1
+def {g} 200
+useg 1
+defun {evalhere x} {eval {+ x 1}}
+evalhere 41
+defun {apply-code code x} {eval code}
+defun {outer x} {apply-code {+ x 1000} 5}
+outer 1
+defun {outer2 z} {apply-code {+ z 1000} 5}
+outer2 1
+defun {mkq x} {{x}}
+mkq 5
+eval (mkq 5)
+def {x} 77
+eval (mkq 5)
+defun {dup x x} {x}
+dup 1 2
+defun {f3 a b c} {list a b c}
+def {p1} (f3 1)
+def {p2} (p1 2)
+p2 3
+p1 9 8
+p2
+p1
+== p1 p1
+== p1 (f3 1)
+defun {twice f x} {f (f x)}
+twice (adder 10) 1
+defun {mapn f l} {if (== l nil) {nil} {join (list (f (eval (head l)))) (mapn f (tail l))}}
+mapn (lambda {v} {* v v}) {1 2 3}
+defun {deffer v} {def {globv} v}
+deffer 9
+globv
+defun {condf n} {cond {(== n 0) {"zero"}} {(> n 0) {(+ n 100)}} {otherwise {n}}}
+condf 0
+condf 5
+condf -5
+defun {casef n} {case n {1 {n}} {otherwise {(* n 2)}}}
+casef 1
+casef 7
+defun {whenf n} {when (> n 0) {print n} {+ n n}}
+whenf 3
+defun {doin a} {do {print a} {+ a 1}}
+doin 4
+defun {nest a} {do {defun {inner b} {+ a b}} {inner 1}}
+nest 10
+inner 5
+defun {lazy a} {lambda {} {a}}
+(lazy 9) ()
+defun {selfref n} {if (== n 0) {{done}} {selfref (- n 1)}}
+selfref 3
+defun {retlam} {lambda {q} {q}}
+(retlam ()) 5
+defun {hof} {adder}
+((hof ()) 1) 2
+defun {pa a b} {lambda {c} {+ a b c}}
+((pa 1 2) 3)
+def {pp} (pa 1)
+((pp 2) 3)
@@ -0,0 +1,12 @@
+def {s} "hello world"
+head s
+tail s
+tail (tail s)
+join s "!" (tail s)
+len (tail s)
+== (tail "xab") "ab"
+== (head s) "h"
+head (tail (tail s))
+def {e} ""
+len e
+head e
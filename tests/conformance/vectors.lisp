@@ -0,0 +1,28 @@
+(def {v} (vector 1 2 3 4 5))
+(print v (type v) (len v))
+(print (nth v 0) (nth v 4) (slice v 1 3) (head v) (tail v))
+(print (+ v 1) (- v) (- 10 v) (* v v) (/ (* v 10) 3) (% v 2) (^ v 2))
+(print (+ v (vector 5 4 3 2 1) 100))
+(print (join v (vector 9) (tail v)))
+(print (sum v) (dot v v) (sum (range 0 100000)))
+(print (to-list v) (to-vector {7 8 9}) (== (to-vector (to-list v)) v) (== v (slice v 0 4)))
+(print (map (lambda {x y} {* x y}) v v))
+(print (map (lambda {x} {+ x 1}) (range 0 10)))
+(print (! (vector 0 1 2)) (&& (vector 1 0 1) 1))
+(print (range 5 3) (len (range -3 3)) (slice {1 2 3 4} 1 3) (slice "hello" 1 4) (nth {a b c} 2) (nth "abc" 1))
+(print (+ (vector 2147483646 0 0 0 0) 1))
+(+ (vector 2147483647 0 0 0 0) 1)
+(+ (vector 0 0 0 0 0 0 0 2147483647) 1)
+(- (vector 0 0 0 0 -2147483647) 2)
+(- (vector -2147483648))
+(+ v (vector 1 2))
+(+ v "a")
+(nth v 5)
+(slice v 2 1)
+(map (lambda {x} {list x}) v)
+(head (vector))
+(dot v (range 0 5))
+(print (dot v (range 0 5)))
+(print (eval {+ 1 2}) (vector))
+(range 0 134217729)
+(range -2147483648 2147483647)
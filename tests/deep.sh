@@ -0,0 +1,48 @@
+#!/bin/sh
+# Lists nested a million deep, which either engine must read, compare, hash, print and free,
+# and a function whose body is nested as deep, which it must resolve, compile and call, without
+# running out of stack.
+# usage: tests/deep.sh [lisp.out]
+
+LISP=${1:-build/lisp.out}
+DEPTH=${DEPTH:-1000000}
+TMP=${TMPDIR:-/tmp}/deep.$$
+mkdir -p "$TMP" || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+awk -v depth="$DEPTH" -v script="$TMP/deep.lisp" -v expected="$TMP/expected" 'BEGIN {
+    opening = "{"; closing = "}"
+    while (length(opening) < depth) { opening = opening opening; closing = closing closing }
+    opening = substr(opening, 1, depth); closing = substr(closing, 1, depth)
+    list = opening "x" closing
+    call = opening "y" closing
+    gsub(/{/, "(", call); gsub(/}/, ")", call)
+    print "(def {a} " list ")" > script
+    print "(def {b} " list ")" > script
+    print "(print (== a b) (== a {x}))" > script
+    print "(defun {id v} {v})" > script
+    print "(def {memo-id} (memoize id))" > script
+    print "(print (== (memo-id a) (memo-id b)) (memo-stats memo-id))" > script
+    print "a" > script
+    print "(defun {f y} {" call "})" > script
+    print "(f 7)" > script
+    print "1 0" > expected
+    print "1 {{hits 1} {misses 1} {entries 1} {capacity 4096} {evictions 0}}" > expected
+    print list > expected
+    print 7 > expected
+}'
+
+failed=0
+for engine in "" --bytecode; do
+    name=${engine:-tree}
+    if "$LISP" $engine "$TMP/deep.lisp" > "$TMP/output" 2>&1 < /dev/null &&
+        cmp -s "$TMP/expected" "$TMP/output"; then
+        echo "ok      deep ${name#--}"
+    else
+        echo "FAILED  deep ${name#--}"
+        head -c 1000 "$TMP/output"
+        failed=$((failed + 1))
+    fi
+done
+
+[ "$failed" -eq 0 ]
@@ -0,0 +1,33 @@
+#!/bin/sh
+# Runs the cache.lisp of the conformance corpus in isolates on several threads, with either
+# engine, between isolates that keep deleting and re-defining the same globals, and fails unless
+# each run prints the expected output: a global cached in one isolate must never be answered
+# from, or invalidated by, another.
+# usage: tests/isolates.sh [lisp.out]
+
+LISP=${1:-build/lisp.out}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/isolates.$$
+mkdir -p "$TMP" || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+cache="$DIR/conformance/cache.lisp"
+churn="$DIR/isolates/churn.lisp"
+for run in 1 2 3 4; do cat "$DIR/conformance/cache.out"; done > "$TMP/expected"
+
+failed=0
+for engine in "" --bytecode; do
+    name=${engine:-tree}
+    "$LISP" $engine --threads 4 --isolates \
+        "$churn" "$cache" "$churn" "$cache" "$churn" "$cache" "$churn" "$cache" "$churn" \
+        > "$TMP/output" 2>&1 < /dev/null
+    if cmp -s "$TMP/expected" "$TMP/output"; then
+        echo "ok      isolates ${name#--}"
+    else
+        echo "FAILED  isolates ${name#--}"
+        diff -u "$TMP/expected" "$TMP/output"
+        failed=$((failed + 1))
+    fi
+done
+
+[ "$failed" -eq 0 ]
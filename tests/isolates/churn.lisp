@@ -0,0 +1,4 @@
+(def {g} 0)
+(defun {f x} {+ x g})
+(defun {churn n} {if (== n 0) {()} {do {del {g}} {def {g} n} {def {unrelated} (f n)} {churn (- n 1)}}})
+(churn 20000)
@@ -0,0 +1,30 @@
+#!/bin/sh
+# Leak regression for the collector, with either engine. Isolates run one after another on one
+# thread, so that they share a pool: each round of closures.lisp makes closures in cycles with
+# its global environment and fails unless live objects and environments return to where they
+# were, and the baseline.lisp runs around them show that dropping the global environment frees
+# everything the round left. cycle.lisp redefines nothing, so the functions it defines are
+# freed with its global environment by the collector alone, never by reference counting.
+# usage: tests/leak.sh [lisp.out]
+
+LISP=${1:-build/lisp.out}
+DIR=$(dirname "$0")/leak
+
+failed=0
+for engine in "" --bytecode; do
+    name=${engine:-tree}
+    output=$("$LISP" $engine --threads 1 --isolates \
+        "$DIR/baseline.lisp" "$DIR/closures.lisp" "$DIR/baseline.lisp" "$DIR/closures.lisp" \
+        "$DIR/baseline.lisp" "$DIR/cycle.lisp" "$DIR/baseline.lisp" 2>&1 < /dev/null)
+    status=$?
+    baselines=$(echo "$output" | sort -u | wc -l)
+    if [ "$status" -eq 0 ] && [ "$baselines" -eq 1 ]; then
+        echo "ok      leak ${name#--}"
+    else
+        echo "FAILED  leak ${name#--}"
+        echo "$output"
+        failed=$((failed + 1))
+    fi
+done
+
+[ "$failed" -eq 0 ]
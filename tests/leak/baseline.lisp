@@ -0,0 +1 @@
+(print (nth (nth (alloc-stats ()) 3) 1) (nth (nth (gc-stats ()) 1) 1))
@@ -0,0 +1,12 @@
+(defun {live} {nth (nth (alloc-stats ()) 3) 1})
+(defun {environments} {nth (nth (gc-stats ()) 1) 1})
+(defun {measure names} {def names (live ()) (environments ())})
+(defun {mk x} {lambda {y} {+ x y}})
+(defun {round n} {do {def {f} (mk n)} {def {g} (lambda {z} {f z})} {def {h} (lambda {q} {h q})}})
+(defun {rounds n} {if (== n 0) {()} {do {round n} {rounds (- n 1)}}})
+(rounds 1)
+(measure {objects environments-before})
+(measure {objects environments-before})
+(rounds 20000)
+(measure {objects-after environments-after})
+(if (&& (== objects objects-after) (== environments-before environments-after)) {()} {do {print "live objects" objects objects-after "environments" environments-before environments-after} {exit 1}})
@@ -0,0 +1,5 @@
+(defun {loop n} {if (== n 0) {n} {loop (- n 1)}})
+(defun {adder x} {lambda {y} {+ x y}})
+(def {add} (adder 1))
+(def {words} {loop adder add})
+(def {result} (loop (add 9)))
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Options that take a file must fail with a usage error or name the file when it is missing,
+# is another option, or cannot be opened, before any script runs.
+# usage: tests/options.sh [lisp.out]
+
+LISP=${1:-build/lisp.out}
+case $LISP in /*) ;; *) LISP=$(pwd)/$LISP ;; esac
+TMP=${TMPDIR:-/tmp}/options.$$
+mkdir -p "$TMP" || exit 1
+trap 'rm -rf "$TMP"' EXIT
+echo '(print "ran")' > "$TMP/script.lisp"
+
+failed=0
+check() {
+    expected=$1
+    shift
+    output=$(cd "$TMP" && "$LISP" "$@" 2>&1 < /dev/null)
+    status=$?
+    if [ "$status" -ne 0 ] && [ "${output#$expected}" != "$output" ] && [ ! -e "$TMP/--time" ]; then
+        echo "ok      options $*"
+    else
+        echo "FAILED  options $*"
+        echo "$output"
+        failed=$((failed + 1))
+    fi
+    rm -f "$TMP/--time"
+}
+
+check "Usage:" --profile
+check "Usage:" --profile --time script.lisp
+check "Usage:" --image
+check "Usage:" --image --bytecode script.lisp
+check "Error: cannot open file missing.image" --image missing.image script.lisp
+check "Error: cannot open file missing.image" --isolates --image missing.image script.lisp script.lisp
+check "Error: cannot open file missing/stacks" --profile missing/stacks script.lisp
+
+[ "$failed" -eq 0 ]